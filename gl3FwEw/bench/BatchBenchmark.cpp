@@ -0,0 +1,298 @@
+// 2D quad benchmark: submits N quads per frame (a 2D overlay / particle workload) through
+// each quad renderer and reports the CPU time of begin() .. end(), GPU time, batches and
+// bytes uploaded per frame.
+//
+//   batch  - BatchRenderer: 4 x 24 byte vertices per quad + a shared index buffer
+//   sprite - SpriteRenderer: one 32 byte instance per quad, corners from gl_VertexID
+//
+//   fill_ms:   begin() and the draw calls of the renderer, including the flushes of full batches
+//   submit_ms: fill plus end(), i.e. everything the overlay costs the render thread.
+//              Software drivers (llvmpipe) shade vertices inside the GL draw, which
+//              lands here too; budget against a hardware driver
+//
+// usage: gl3FwEwBatchBench [--quads N] [--textures T] [--max-quads Q] [--frames F] [--warmup W]
+//                          [--width X] [--height Y] [--renderers batch,sprite] [--budget-ms B]
+//                          [--atlas] [--check] [--seed S] [--out file.json]
+//   --textures: distinct textures, the quads are sorted by texture (0 = solid quads only)
+//   --atlas:    pack the textures and a white texel into a TextureAtlas page instead, so
+//               every quad draws from one texture
+//   --max-quads: batch capacity of both renderers
+//   shaders are loaded from res/shaders/, run it from gl3FwEw/
+//   --check:    exit with 1 if a renderer's p95 CPU submit time is over --budget-ms (default 1)
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "BatchRenderer.h"
+#include "SpriteRenderer.h"
+#include "Texture.h"
+#include "TextureAtlas.h"
+#include "FramePacer.h"
+#include "BenchUtils.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct RendererResult {
+	std::string name;
+	unsigned int batches;			// per frame
+	unsigned long long bytesUploaded;	// per frame
+	bench::Stats fill;
+	bench::Stats submit;
+	bench::Stats gpu;
+	bench::Stats frame;
+	unsigned int checksum;
+};
+
+struct QuadData {
+	float rect[4];		// x, y, width, height in pixels
+	float color[4];
+	int texture;		// index into the textures, -1 = solid
+};
+
+// what a quad is drawn with: its own texture, or its region of the atlas page
+struct QuadTexture {
+	const Texture2D* texture;	// nullptr = solid
+	const float* uv;			// nullptr = the whole texture
+};
+
+static void makeCheckerPixels(unsigned int seed, unsigned char pixels[8 * 8 * 4])
+{
+	bench::Random random(seed);
+	unsigned char a[4], b[4];
+	for (int c = 0; c < 4; c++) {
+		a[c] = (unsigned char)(random.nextUInt() | 0x40);
+		b[c] = (unsigned char)(a[c] / 2);
+	}
+	for (int y = 0; y < 8; y++)
+		for (int x = 0; x < 8; x++)
+			memcpy(&pixels[(y * 8 + x) * 4], ((x ^ y) & 1) ? a : b, 4);
+}
+
+static Texture2D* makeCheckerTexture(unsigned int seed)
+{
+	unsigned char pixels[8 * 8 * 4];
+	makeCheckerPixels(seed, pixels);
+	Texture2D* texture = new Texture2D(8, 8, pixels, TextureFormat::RGBA8, 1);
+	texture->setSampler(SamplerState::nearest(SamplerWrap::Repeat));
+	return texture;
+}
+
+static unsigned int imageChecksum(int width, int height)
+{
+	std::vector<unsigned char> pixels(width * height * 4);
+	GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	for (unsigned char c : pixels)
+		hash = (hash ^ c) * 16777619u;
+	return hash;
+}
+
+// draws every quad through one renderer; begin / draw / end are the same shape for both
+template<typename QuadRenderer, typename DrawQuad>
+static RendererResult runRenderer(const std::string& name, QuadRenderer& quadRenderer, DrawQuad drawQuad, Renderer& renderer,
+	const std::vector<QuadData>& quads, const float* projection, int frames, int warmup, int width, int height)
+{
+	RendererResult result;
+	result.name = name;
+	result.batches = 0;
+	result.bytesUploaded = 0;
+
+	std::vector<double> fillTimes, submitTimes, frameTimes, gpuTimes;
+	std::vector<unsigned int> queries(frames);
+	GLCall(glGenQueries(frames, queries.data()));
+
+	FramePacer pacer(2);
+	for (int frame = 0; frame < warmup + frames; frame++) {
+		bool measured = frame >= warmup;
+		double frameStart = bench::now();
+		pacer.beginFrame();
+
+		renderer.clear();
+		if (measured) {
+			GLCall(glBeginQuery(GL_TIME_ELAPSED, queries[frame - warmup]));
+		}
+
+		double submitStart = bench::now();
+		quadRenderer.begin(projection);
+		for (const QuadData& quad : quads)
+			drawQuad(quad);
+		double fillEnd = bench::now();
+		quadRenderer.end();
+		double submitEnd = bench::now();
+
+		if (measured) {
+			GLCall(glEndQuery(GL_TIME_ELAPSED));
+		}
+		GLCall(glFlush());
+		pacer.endFrame();
+		renderer.endFrame();
+
+		if (measured) {
+			fillTimes.push_back((fillEnd - submitStart) * 1000.0);
+			submitTimes.push_back((submitEnd - submitStart) * 1000.0);
+			frameTimes.push_back((bench::now() - frameStart) * 1000.0);
+		}
+	}
+	result.batches = quadRenderer.getStats().flushes;
+	result.bytesUploaded = renderer.getFrameStats().bytesUploaded;
+
+	GLCall(glFinish());
+	for (int i = 0; i < frames; i++) {
+		GLuint64 elapsed = 0;
+		GLCall(glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed));
+		gpuTimes.push_back(elapsed / 1000000.0);
+	}
+	GLCall(glDeleteQueries(frames, queries.data()));
+
+	result.fill = bench::Stats::compute(fillTimes);
+	result.submit = bench::Stats::compute(submitTimes);
+	result.gpu = bench::Stats::compute(gpuTimes);
+	result.frame = bench::Stats::compute(frameTimes);
+	result.checksum = imageChecksum(width, height);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int quadCount = (int)bench::getArg(argc, argv, "--quads", 20000LL);
+	int textureCount = (int)bench::getArg(argc, argv, "--textures", 4LL);
+	int maxQuads = (int)bench::getArg(argc, argv, "--max-quads", (long long)BatchRenderer::DefaultMaxQuads);
+	int frames = (int)bench::getArg(argc, argv, "--frames", 200LL);
+	int warmup = (int)bench::getArg(argc, argv, "--warmup", 20LL);
+	int width = (int)bench::getArg(argc, argv, "--width", 1280LL);
+	int height = (int)bench::getArg(argc, argv, "--height", 720LL);
+	std::vector<std::string> renderers = bench::splitList(bench::getArg(argc, argv, "--renderers", "batch,sprite"));
+	double budgetMs = atof(bench::getArg(argc, argv, "--budget-ms", "1.0"));
+	bool check = bench::hasArg(argc, argv, "--check");
+	bool useAtlas = bench::hasArg(argc, argv, "--atlas");
+	unsigned long long seed = (unsigned long long)bench::getArg(argc, argv, "--seed", 1LL);
+	if (quadCount < 0) quadCount = 0;
+	if (textureCount < 0) textureCount = 0;
+	if (frames < 1) frames = 1;
+
+	HeadlessContext context(width, height);
+	if (!context.isValid())
+		return -1;
+
+	std::vector<QuadData> quads(quadCount);
+	bench::Random random(seed);
+	for (QuadData& quad : quads) {
+		float size = random.nextFloat(2.0f, 12.0f);
+		quad.rect[0] = random.nextFloat(0.0f, width - size);
+		quad.rect[1] = random.nextFloat(0.0f, height - size);
+		quad.rect[2] = size;
+		quad.rect[3] = size;
+		for (int c = 0; c < 3; c++)
+			quad.color[c] = random.nextFloat(0.2f, 1.0f);
+		quad.color[3] = 1.0f;
+		quad.texture = textureCount > 0 && random.nextUInt() % 2 ? (int)(random.nextUInt() % textureCount) : -1;
+	}
+	// layers are drawn sorted by texture, SpriteRenderer flushes on every change
+	std::stable_sort(quads.begin(), quads.end(), [](const QuadData& a, const QuadData& b) {
+		return a.texture < b.texture;
+	});
+
+	std::vector<RendererResult> results;
+	{
+		// index 0 is solid, quad.texture + 1 the rest
+		std::vector<std::unique_ptr<Texture2D>> textures;
+		std::unique_ptr<TextureAtlas> atlas;
+		std::vector<QuadTexture> quadTextures(textureCount + 1, QuadTexture{ nullptr, nullptr });
+		if (useAtlas) {
+			atlas.reset(new TextureAtlas(256));
+			unsigned int white = 0xffffffff;
+			std::vector<TextureAtlas::Handle> handles(1, atlas->add(1, 1, &white));
+			for (int i = 0; i < textureCount; i++) {
+				unsigned char pixels[8 * 8 * 4];
+				makeCheckerPixels(i + 1, pixels);
+				handles.push_back(atlas->add(8, 8, pixels));
+			}
+			atlas->update();
+			for (size_t i = 0; i < handles.size(); i++) {
+				if (handles[i] == TextureAtlas::InvalidHandle)
+					continue;	// out of atlas space, drawn solid
+				const AtlasRegion& region = atlas->getRegion(handles[i]);
+				quadTextures[i] = { &atlas->getPage(region.page), region.uv };
+			}
+		}
+		else {
+			for (int i = 0; i < textureCount; i++) {
+				textures.emplace_back(makeCheckerTexture(i + 1));
+				quadTextures[i + 1].texture = textures.back().get();
+			}
+		}
+
+		Renderer renderer;
+		float projection[16];
+		BatchRenderer::ortho(0.0f, (float)width, 0.0f, (float)height, projection);
+		GLCall(glEnable(GL_BLEND));
+		GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+		for (const std::string& name : renderers) {
+			if (name == "batch") {
+				Shader shader("res/shaders/batch.shader");
+				BatchRenderer batch(renderer, shader, maxQuads);
+				results.push_back(runRenderer(name, batch, [&batch, &quadTextures](const QuadData& quad) {
+					const QuadTexture& texture = quadTextures[quad.texture + 1];
+					batch.drawQuad(quad.rect[0], quad.rect[1], quad.rect[2], quad.rect[3], texture.texture, texture.uv, quad.color);
+				}, renderer, quads, projection, frames, warmup, width, height));
+			}
+			else if (name == "sprite") {
+				Shader shader("res/shaders/sprite.shader");
+				SpriteRenderer sprites(renderer, shader, maxQuads);
+				results.push_back(runRenderer(name, sprites, [&sprites, &quadTextures](const QuadData& quad) {
+					const QuadTexture& texture = quadTextures[quad.texture + 1];
+					sprites.drawSprite(quad.rect[0], quad.rect[1], quad.rect[2], quad.rect[3], texture.texture, texture.uv, quad.color);
+				}, renderer, quads, projection, frames, warmup, width, height));
+			}
+		}
+
+		GLCall(glDisable(GL_BLEND));
+	}
+
+	bool withinBudget = true;
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "batch");
+	json.member("renderer", (const char*)glGetString(GL_RENDERER));
+	json.member("version", (const char*)glGetString(GL_VERSION));
+	json.member("quads", quadCount);
+	json.member("textures", textureCount);
+	json.member("atlas", useAtlas);
+	json.member("max_quads", maxQuads);
+	json.member("frames", frames);
+	json.member("budget_ms", budgetMs);
+	json.key("results");
+	json.beginArray();
+	for (const RendererResult& r : results) {
+		bool within = r.submit.p95 <= budgetMs;
+		withinBudget = withinBudget && within;
+		json.beginObject();
+		json.member("quad_renderer", r.name);
+		json.member("batches_per_frame", r.batches);
+		json.member("bytes_per_frame", r.bytesUploaded);
+		json.member("bytes_per_quad", quadCount > 0 ? (double)r.bytesUploaded / quadCount : 0.0);
+		json.stats("fill_ms", r.fill);
+		json.stats("submit_ms", r.submit);
+		json.stats("gpu_ms", r.gpu);
+		json.stats("frame_ms", r.frame);
+		json.member("quads_per_ms", r.submit.mean > 0.0 ? quadCount / r.submit.mean : 0.0);
+		json.member("within_budget", within);
+		json.member("checksum", r.checksum);
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	bench::closeOutput(output);
+
+	if (check && !withinBudget) {
+		fprintf(stderr, "a renderer's submit p95 is over the %.3f ms budget\n", budgetMs);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+// Small helpers shared by the benchmark executables: argument parsing,
+// timing, percentile statistics and a minimal JSON writer.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+	inline double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// "--name value" lookups; flags without a value use hasArg
+	inline const char* getArg(int argc, char** argv, const char* name, const char* fallback)
+	{
+		for (int i = 1; i + 1 < argc; i++)
+			if (strcmp(argv[i], name) == 0)
+				return argv[i + 1];
+		return fallback;
+	}
+
+	inline long long getArg(int argc, char** argv, const char* name, long long fallback)
+	{
+		const char* value = getArg(argc, argv, name, (const char*)nullptr);
+		return value ? atoll(value) : fallback;
+	}
+
+	inline bool hasArg(int argc, char** argv, const char* name)
+	{
+		for (int i = 1; i < argc; i++)
+			if (strcmp(argv[i], name) == 0)
+				return true;
+		return false;
+	}
+
+	// "a,b,c" -> { "a", "b", "c" }
+	inline std::vector<std::string> splitList(const std::string& list)
+	{
+		std::vector<std::string> items;
+		size_t start = 0;
+		while (start <= list.size()) {
+			size_t end = list.find(',', start);
+			if (end == std::string::npos) end = list.size();
+			if (end > start)
+				items.push_back(list.substr(start, end - start));
+			start = end + 1;
+		}
+		return items;
+	}
+
+	// deterministic across platforms, unlike the <random> distributions
+	class Random
+	{
+	private:
+		unsigned long long m_State;
+	public:
+		Random(unsigned long long seed) : m_State(seed) {}
+
+		inline unsigned int nextUInt() {
+			m_State = m_State * 6364136223846793005ULL + 1442695040888963407ULL;
+			return (unsigned int)(m_State >> 33);
+		}
+		// [min, max)
+		inline float nextFloat(float min, float max) {
+			return min + (max - min) * (nextUInt() / 2147483648.0f);
+		}
+	};
+
+	struct Stats
+	{
+		double mean, p50, p95, p99, min, max;
+
+		static Stats compute(std::vector<double> samples)
+		{
+			Stats stats = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+			if (samples.empty())
+				return stats;
+
+			std::sort(samples.begin(), samples.end());
+			double sum = 0.0;
+			for (double sample : samples)
+				sum += sample;
+
+			stats.mean = sum / samples.size();
+			stats.p50 = percentile(samples, 0.50);
+			stats.p95 = percentile(samples, 0.95);
+			stats.p99 = percentile(samples, 0.99);
+			stats.min = samples.front();
+			stats.max = samples.back();
+			return stats;
+		}
+
+		// nearest rank on sorted samples
+		static double percentile(const std::vector<double>& sorted, double p)
+		{
+			size_t rank = (size_t)(p * sorted.size() + 0.5);
+			if (rank < 1) rank = 1;
+			if (rank > sorted.size()) rank = sorted.size();
+			return sorted[rank - 1];
+		}
+	};
+
+	// Streams JSON with the commas and nesting taken care of; no pretty printing beyond newlines.
+	class JsonWriter
+	{
+	private:
+		FILE* m_File;
+		std::vector<bool> m_First;	// per nesting level: no member written yet
+		bool m_AfterKey;
+
+		void separator() {
+			if (m_AfterKey) {
+				m_AfterKey = false;
+				return;
+			}
+			if (!m_First.empty()) {
+				if (!m_First.back())
+					fputs(",", m_File);
+				m_First.back() = false;
+			}
+		}
+
+		void string(const char* text) {
+			fputc('"', m_File);
+			for (const char* c = text; *c; c++) {
+				switch (*c) {
+					case '"':	fputs("\\\"", m_File); break;
+					case '\\':	fputs("\\\\", m_File); break;
+					case '\n':	fputs("\\n", m_File); break;
+					case '\t':	fputs("\\t", m_File); break;
+					default:
+						if ((unsigned char)*c < 0x20) fprintf(m_File, "\\u%04x", *c);
+						else fputc(*c, m_File);
+				}
+			}
+			fputc('"', m_File);
+		}
+
+	public:
+		JsonWriter(FILE* file) : m_File(file), m_AfterKey(false) {}
+
+		void beginObject() { separator(); fputs("{", m_File); m_First.push_back(true); }
+		void endObject() { m_First.pop_back(); fputs("}", m_File); if (m_First.empty()) fputs("\n", m_File); }
+		void beginArray() { separator(); fputs("[", m_File); m_First.push_back(true); }
+		void endArray() { m_First.pop_back(); fputs("]", m_File); }
+
+		void key(const char* name) { separator(); string(name); fputs(":", m_File); m_AfterKey = true; }
+
+		void value(const char* text) { separator(); string(text ? text : ""); }
+		void value(const std::string& text) { value(text.c_str()); }
+		void value(double number) { separator(); fprintf(m_File, "%.6g", number); }
+		void value(long long number) { separator(); fprintf(m_File, "%lld", number); }
+		void value(unsigned int number) { value((long long)number); }
+		void value(unsigned long number) { value((long long)number); }
+		void value(unsigned long long number) { value((long long)number); }
+		void value(int number) { value((long long)number); }
+		void value(bool flag) { separator(); fputs(flag ? "true" : "false", m_File); }
+
+		template<typename T>
+		void member(const char* name, const T& v) { key(name); value(v); }
+
+		void stats(const char* name, const Stats& stats) {
+			key(name);
+			beginObject();
+			member("mean", stats.mean);
+			member("p50", stats.p50);
+			member("p95", stats.p95);
+			member("p99", stats.p99);
+			member("min", stats.min);
+			member("max", stats.max);
+			endObject();
+		}
+	};
+
+	// --out <path> or stdout
+	inline FILE* openOutput(int argc, char** argv)
+	{
+		const char* path = getArg(argc, argv, "--out", (const char*)nullptr);
+		if (!path)
+			return stdout;
+		FILE* file = fopen(path, "w");
+		if (!file) {
+			fprintf(stderr, "Can't open %s for writing\n", path);
+			return stdout;
+		}
+		return file;
+	}
+
+	inline void closeOutput(FILE* file)
+	{
+		if (file != stdout)
+			fclose(file);
+	}
+
+}
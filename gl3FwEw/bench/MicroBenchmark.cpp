@@ -0,0 +1,277 @@
+// CPU micro-benchmarks for the wrapper hot paths. GL entry points are replaced by
+// stubs through GLEW's function table, so no context (and no GPU) is needed.
+// Reports ns/op and heap allocations/op as JSON.
+//
+// usage: gl3FwEwMicroBench [--min-time seconds] [--filter name] [--check] [--out file.json]
+//   --check: exit with 1 if a case allocates more than its budget
+
+#include "Renderer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "Shader.h"
+#include "MipGenerator.h"
+#include "Log.h"
+#include "BenchUtils.h"
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+
+// ---- allocation counting ---------------------------------------------------
+
+static std::atomic<unsigned long long> s_Allocations(0);
+
+void* operator new(size_t size)
+{
+	s_Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+// ---- stub GL function table ------------------------------------------------
+
+static unsigned int s_NextName = 1;
+
+static void GLAPIENTRY stubGenNames(GLsizei n, GLuint* names) { for (GLsizei i = 0; i < n; i++) names[i] = s_NextName++; }
+static void GLAPIENTRY stubDeleteNames(GLsizei, const GLuint*) {}
+static void GLAPIENTRY stubBindBuffer(GLenum, GLuint) {}
+static void GLAPIENTRY stubBufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+static void GLAPIENTRY stubBindVertexArray(GLuint) {}
+static void GLAPIENTRY stubEnableVertexAttribArray(GLuint) {}
+static void GLAPIENTRY stubVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+static void GLAPIENTRY stubVertexAttribDivisor(GLuint, GLuint) {}
+static GLuint GLAPIENTRY stubCreateProgram() { return s_NextName++; }
+static GLuint GLAPIENTRY stubCreateShader(GLenum) { return s_NextName++; }
+static void GLAPIENTRY stubShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+static void GLAPIENTRY stubName(GLuint) {}
+static void GLAPIENTRY stubAttachShader(GLuint, GLuint) {}
+static void GLAPIENTRY stubGetShaderiv(GLuint, GLenum, GLint* value) { *value = GL_TRUE; }
+static void GLAPIENTRY stubUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) {}
+static GLint GLAPIENTRY stubGetUniformLocation(GLuint, const GLchar* name)
+{
+	GLint location = 0;
+	for (const GLchar* c = name; *c; c++)
+		location = location * 31 + *c;
+	return location & 0xffff;
+}
+
+static void installStubs()
+{
+	__glewGenBuffers = stubGenNames;
+	__glewDeleteBuffers = stubDeleteNames;
+	__glewBindBuffer = stubBindBuffer;
+	__glewBufferData = stubBufferData;
+	__glewGenVertexArrays = stubGenNames;
+	__glewDeleteVertexArrays = stubDeleteNames;
+	__glewBindVertexArray = stubBindVertexArray;
+	__glewEnableVertexAttribArray = stubEnableVertexAttribArray;
+	__glewVertexAttribPointer = stubVertexAttribPointer;
+	__glewVertexAttribDivisor = stubVertexAttribDivisor;
+	__glewCreateProgram = stubCreateProgram;
+	__glewCreateShader = stubCreateShader;
+	__glewShaderSource = stubShaderSource;
+	__glewCompileShader = stubName;
+	__glewGetShaderiv = stubGetShaderiv;
+	__glewAttachShader = stubAttachShader;
+	__glewLinkProgram = stubName;
+	__glewValidateProgram = stubName;
+	__glewDeleteShader = stubName;
+	__glewDeleteProgram = stubName;
+	__glewUseProgram = stubName;
+	__glewGetUniformLocation = stubGetUniformLocation;
+	__glewUniform4f = stubUniform4f;
+}
+
+// ---- harness ---------------------------------------------------------------
+
+// keeps the optimizer from throwing away benchmark results
+static volatile unsigned long long s_Sink;
+
+struct BenchCase {
+	const char* name;
+	double maxAllocationsPerOp;		// budget checked with --check, negative = unchecked
+	std::function<void(long long iterations)> run;
+};
+
+struct BenchResult {
+	long long iterations;
+	double nsPerOp;
+	double allocationsPerOp;
+};
+
+static BenchResult runCase(const BenchCase& benchCase, double minTime)
+{
+	// grow the iteration count until one batch takes long enough to time reliably
+	long long iterations = 1;
+	while (true) {
+		unsigned long long allocations = s_Allocations.load();
+		double start = bench::now();
+		benchCase.run(iterations);
+		double elapsed = bench::now() - start;
+		allocations = s_Allocations.load() - allocations;
+
+		if (elapsed >= minTime || iterations >= (1LL << 40)) {
+			BenchResult result;
+			result.iterations = iterations;
+			result.nsPerOp = elapsed * 1e9 / iterations;
+			result.allocationsPerOp = (double)allocations / iterations;
+			return result;
+		}
+
+		long long next = elapsed > 0.0 ? (long long)(iterations * minTime / elapsed * 1.2) : iterations * 10;
+		if (next > iterations * 10) next = iterations * 10;
+		iterations = next > iterations ? next : iterations + 1;
+	}
+}
+
+static std::string writeShaderFile()
+{
+	const char* dir = getenv("TMPDIR");
+	if (!dir) dir = getenv("TEMP");
+	if (!dir) dir = "/tmp";
+	std::string path = std::string(dir) + "/gl3FwEwMicroBench.shader";
+
+	// the size of a typical lit shader rather than the 20 line basic.shader
+	std::ofstream file(path);
+	file << "#shader vertex\n#version 330 core\n\n";
+	file << "layout(location = 0) in vec4 position;\nlayout(location = 1) in vec2 texCoord;\n";
+	for (int i = 0; i < 40; i++)
+		file << "uniform vec4 u_Param" << i << "; // parameter " << i << " of the material block\n";
+	file << "void main()\n{\n\tgl_Position = position;\n};\n\n";
+	file << "#shader fragment\n#version 330 core\n\nlayout(location = 0) out vec4 color;\nuniform vec4 u_Color;\n";
+	for (int i = 0; i < 40; i++)
+		file << "vec4 shade" << i << "(vec4 c) { return c * u_Color + vec4(" << i << ".0 / 40.0); }\n";
+	file << "void main()\n{\n\tcolor = shade0(u_Color);\n};\n";
+	return path;
+}
+
+int main(int argc, char** argv)
+{
+	double minTime = atof(bench::getArg(argc, argv, "--min-time", "0.2"));
+	const char* filter = bench::getArg(argc, argv, "--filter", (const char*)nullptr);
+	bool check = bench::hasArg(argc, argv, "--check");
+
+	installStubs();
+	// keep the wrappers' diagnostics (the stubs have no uniforms) out of the timings
+	Log::setLevel(LogLevel::Error);
+	std::string shaderPath = writeShaderFile();
+
+	VertexBufferLayout layout;
+	layout.push<float>(3);
+	layout.push<float>(2);
+	layout.push<unsigned char>(4);
+
+	float vertices[4 * 6] = {};
+	VertexBuffer vertexBuffer(vertices, sizeof(vertices));
+	VertexArray vertexArray;
+
+	Shader shader(Shader::parseShader(shaderPath));
+	shader.getUniformLocation("u_Color");
+	const std::string colorName = "u_Color";
+
+	// 512x512 noise for the mip generator
+	const unsigned int mipSize = 512;
+	std::vector<unsigned char> mipSource((size_t)mipSize * mipSize * 4);
+	bench::Random random(7);
+	for (unsigned char& c : mipSource)
+		c = (unsigned char)random.nextUInt();
+	std::vector<std::vector<unsigned char>> mipLevels;
+
+	BenchCase cases[] = {
+		{ "VertexBufferLayout::push", -1.0, [](long long iterations) {
+			for (long long i = 0; i < iterations; i++) {
+				VertexBufferLayout l;
+				l.push<float>(3);
+				l.push<float>(2);
+				l.push<unsigned char>(4);
+				s_Sink = s_Sink + l.getStride();
+			}
+		} },
+		{ "VertexBufferLayout::getElements", 0.0, [&layout](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				s_Sink = s_Sink + layout.getElements().size();
+		} },
+		{ "VertexArray::addBuffer", 0.0, [&vertexArray, &vertexBuffer, &layout](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				vertexArray.addBuffer(vertexBuffer, layout, 0);
+		} },
+		{ "Shader::parseShader", -1.0, [&shaderPath](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				s_Sink = s_Sink + Shader::parseShader(shaderPath).fragmentSource.size();
+		} },
+		{ "Shader::getUniformLocation (cached)", 0.0, [&shader, &colorName](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				s_Sink = s_Sink + shader.getUniformLocation(colorName);
+		} },
+		{ "Shader::setUniform4f", 0.0, [&shader, &colorName](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				shader.setUniform4f(colorName, 1.0f, 0.5f, 0.25f, 1.0f);
+		} },
+		{ "MipGenerator::generate (512, box, sRGB, 1 thread)", -1.0, [&](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				MipGenerator::generate(mipSource.data(), mipSize, mipSize, { MipFilter::Box, MipContent::SRGB, false, 1 }, mipLevels);
+		} },
+		{ "MipGenerator::generate (512, kaiser, sRGB, 1 thread)", -1.0, [&](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				MipGenerator::generate(mipSource.data(), mipSize, mipSize, { MipFilter::Kaiser, MipContent::SRGB, false, 1 }, mipLevels);
+		} },
+		{ "MipGenerator::generate (512, kaiser, normal map)", -1.0, [&](long long iterations) {
+			for (long long i = 0; i < iterations; i++)
+				MipGenerator::generate(mipSource.data(), mipSize, mipSize, MipSettings::normalMap(MipFilter::Kaiser), mipLevels);
+		} },
+	};
+
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "micro");
+	json.member("min_time_s", minTime);
+	json.member("mip_kernels", MipGenerator::getKernelName());
+	json.key("results");
+	json.beginArray();
+
+	bool failed = false;
+	for (const BenchCase& benchCase : cases) {
+		if (filter && !strstr(benchCase.name, filter))
+			continue;
+
+		BenchResult result = runCase(benchCase, minTime);
+		bool overBudget = benchCase.maxAllocationsPerOp >= 0.0 && result.allocationsPerOp > benchCase.maxAllocationsPerOp;
+		failed = failed || overBudget;
+
+		json.beginObject();
+		json.member("name", benchCase.name);
+		json.member("iterations", result.iterations);
+		json.member("ns_per_op", result.nsPerOp);
+		json.member("allocs_per_op", result.allocationsPerOp);
+		if (benchCase.maxAllocationsPerOp >= 0.0)
+			json.member("allocs_budget", benchCase.maxAllocationsPerOp);
+		json.endObject();
+	}
+
+	json.endArray();
+	json.endObject();
+	bench::closeOutput(output);
+	remove(shaderPath.c_str());
+
+	if (check && failed) {
+		fprintf(stderr, "allocation budget exceeded\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,319 @@
+// Headless scene benchmark: renders a deterministic synthetic scene for a fixed
+// number of uncapped frames and reports CPU and GPU frame time percentiles as JSON.
+//
+// usage: gl3FwEwSceneBench [--quads N] [--shaders M] [--uniforms K] [--frames F]
+//                          [--warmup W] [--width X] [--height Y] [--frames-in-flight 1..3]
+//                          [--readback] [--seed S] [--out file.json] [--trace trace.json]
+//                          [--gl-trace calls.bin] [--capture frames.cap] [--capture-frames N]
+//   --trace: also write a Chrome trace of the measured frames (see Profiler) and add the
+//            CPU + GPU scope timings of the last measured frame to the JSON
+//   --gl-trace: record every GLCall (see GLTracer) and write the ring when the run ends
+//   --capture: capture the first N frames (default 1) for gl3FwEwReplay; keep N <= W,
+//              capturing slows the captured frames down
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "FramePacer.h"
+#include "AsyncReadback.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "FrameCapture.h"
+#include "BenchUtils.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SceneConfig {
+	int quads;
+	int shaders;
+	int uniforms;		// uniform updates per frame, spread over the quads
+	int frames;
+	int warmup;
+	int width;
+	int height;
+	int framesInFlight;
+	bool readback;
+	unsigned long long seed;
+};
+
+struct SceneObject {
+	std::unique_ptr<VertexArray> vertexArray;
+	std::unique_ptr<VertexBuffer> vertexBuffer;
+	std::unique_ptr<IndexBuffer> indexBuffer;
+	int shader;
+	float color[4];
+};
+
+// every variant is a distinct program so switching between them is a real program change
+static ShaderProgramSources makeShaderSources(int variant)
+{
+	std::string vertex =
+		"#version 330 core\n"
+		"layout(location = 0) in vec4 position;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = position;\n"
+		"}\n";
+	std::string fragment =
+		"#version 330 core\n"
+		"layout(location = 0) out vec4 color;\n"
+		"uniform vec4 u_Color;\n"
+		"void main()\n"
+		"{\n"
+		"	color = u_Color * " + std::to_string(1.0f - (variant % 16) / 32.0f) + ";\n"
+		"}\n";
+	return { vertex, fragment };
+}
+
+static void buildScene(const SceneConfig& config, std::vector<SceneObject>& objects, std::vector<std::unique_ptr<Shader>>& shaders)
+{
+	bench::Random random(config.seed);
+
+	for (int i = 0; i < config.shaders; i++)
+		shaders.emplace_back(new Shader(makeShaderSources(i)));
+
+	unsigned int indices[] = {
+		0, 1, 2,
+		2, 3, 0
+	};
+
+	VertexBufferLayout layout;
+	layout.push<float>(2);
+
+	objects.resize(config.quads);
+	for (int i = 0; i < config.quads; i++) {
+		float x = random.nextFloat(-1.0f, 0.95f);
+		float y = random.nextFloat(-1.0f, 0.95f);
+		float size = random.nextFloat(0.01f, 0.05f);
+		float positions[] = {
+			x,			y,
+			x + size,	y,
+			x + size,	y + size,
+			x,			y + size,
+		};
+
+		SceneObject& object = objects[i];
+		object.vertexArray.reset(new VertexArray());
+		object.vertexBuffer.reset(new VertexBuffer(positions, sizeof(positions)));
+		object.vertexArray->addBuffer(*object.vertexBuffer, layout);
+		object.indexBuffer.reset(new IndexBuffer(indices, 6));
+		object.shader = i % config.shaders;
+		for (int c = 0; c < 4; c++)
+			object.color[c] = random.nextFloat(0.2f, 1.0f);
+
+		// every program needs its uniform set once even when K is 0
+		if (i < config.shaders) {
+			shaders[object.shader]->bind();
+			shaders[object.shader]->setUniform4f("u_Color", object.color[0], object.color[1], object.color[2], object.color[3]);
+		}
+	}
+}
+
+static void renderFrame(const SceneConfig& config, std::vector<SceneObject>& objects, std::vector<std::unique_ptr<Shader>>& shaders, int frame, Renderer& renderer, GpuProfiler& gpuProfiler)
+{
+	PROFILE_SCOPE("renderFrame");
+	GPU_PROFILE_SCOPE(gpuProfiler, "renderFrame");
+	renderer.clear();
+
+	// K uniform updates spread evenly: every quad gets K / N, the first K % N get one more
+	int perObject = config.uniforms / config.quads;
+	int remainder = config.uniforms % config.quads;
+
+	int boundShader = -1;
+	for (int i = 0; i < config.quads; i++) {
+		SceneObject& object = objects[i];
+		Shader& shader = *shaders[object.shader];
+		if (object.shader != boundShader) {
+			shader.bind();
+			boundShader = object.shader;
+		}
+
+		int updates = perObject + (i < remainder ? 1 : 0);
+		for (int u = 0; u < updates; u++) {
+			float pulse = (float)((frame + u) % 64) / 64.0f;
+			shader.setUniform4f("u_Color", object.color[0] * pulse, object.color[1], object.color[2], object.color[3]);
+		}
+
+		renderer.draw(*object.vertexArray, *object.indexBuffer);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	SceneConfig config;
+	config.quads = (int)bench::getArg(argc, argv, "--quads", 1000LL);
+	config.shaders = (int)bench::getArg(argc, argv, "--shaders", 4LL);
+	config.uniforms = (int)bench::getArg(argc, argv, "--uniforms", 1000LL);
+	config.frames = (int)bench::getArg(argc, argv, "--frames", 500LL);
+	config.warmup = (int)bench::getArg(argc, argv, "--warmup", 50LL);
+	config.width = (int)bench::getArg(argc, argv, "--width", 1280LL);
+	config.height = (int)bench::getArg(argc, argv, "--height", 720LL);
+	config.framesInFlight = (int)bench::getArg(argc, argv, "--frames-in-flight", 2LL);
+	config.readback = bench::hasArg(argc, argv, "--readback");
+	config.seed = (unsigned long long)bench::getArg(argc, argv, "--seed", 1LL);
+	const char* tracePath = bench::getArg(argc, argv, "--trace", (const char*)nullptr);
+	const char* glTracePath = bench::getArg(argc, argv, "--gl-trace", (const char*)nullptr);
+	const char* capturePath = bench::getArg(argc, argv, "--capture", (const char*)nullptr);
+	unsigned int captureFrames = (unsigned int)bench::getArg(argc, argv, "--capture-frames", 1LL);
+	if (config.quads < 1) config.quads = 1;
+	if (config.shaders < 1) config.shaders = 1;
+	if (config.uniforms < 0) config.uniforms = 0;
+	if (config.frames < 1) config.frames = 1;
+
+	Profiler::setThreadName("Main");
+	Profiler::setEnabled(tracePath != nullptr);
+	if (glTracePath) {
+		GLTracer::enable(1 << 20);
+		GLTracer::setDumpOnError(glTracePath);
+	}
+	if (capturePath)
+		FrameCapture::enable();
+
+	HeadlessContext context(config.width, config.height);
+	if (!context.isValid())
+		return -1;
+
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	std::vector<double> waitTimes;
+	unsigned int readbackStalls = 0;
+	unsigned long long readbackChecksum = 0;	// sum of the center pixel's red channel over every readback
+	std::vector<ProfileReportEntry> profile;
+	RenderStatsAverage renderStats = {};
+
+	{
+		std::vector<std::unique_ptr<Shader>> shaders;
+		std::vector<SceneObject> objects;
+		buildScene(config, objects, shaders);
+
+		// one elapsed-time query per measured frame, read once the run is over so they never stall
+		std::vector<unsigned int> queries(config.frames);
+		GLCall(glGenQueries(config.frames, queries.data()));
+
+		FramePacer pacer(config.framesInFlight);
+		AsyncReadback readback(3);
+		GpuProfiler gpuProfiler;
+		Renderer renderer;
+		Renderer::counters().reset();	// the scene's uploads aren't part of any frame
+
+		for (int frame = 0; frame < config.warmup + config.frames; frame++) {
+			bool measured = frame >= config.warmup;
+			double start = bench::now();
+			Profiler::markFrame();
+			gpuProfiler.beginFrame();
+
+			pacer.beginFrame();
+			if (capturePath && frame == 0)
+				FrameCapture::begin(capturePath, captureFrames);
+			if (measured) {
+				GLCall(glBeginQuery(GL_TIME_ELAPSED, queries[frame - config.warmup]));
+			}
+
+			renderFrame(config, objects, shaders, frame, renderer, gpuProfiler);
+
+			if (measured) {
+				GLCall(glEndQuery(GL_TIME_ELAPSED));
+			}
+			if (config.readback) {
+				GPU_PROFILE_SCOPE(gpuProfiler, "readback");
+				readback.capture(0, 0, config.width, config.height, [&readbackChecksum](const unsigned char* pixels, int width, int height) {
+					readbackChecksum += pixels[(width * (height / 2) + width / 2) * 4];
+				});
+				readback.update();
+			}
+			{
+				PROFILE_SCOPE("glFlush");
+				GLCall(glFlush());	// stands in for the swap
+			}
+			gpuProfiler.endFrame();
+			renderer.endFrame();
+			pacer.endFrame();
+
+			if (measured) {
+				cpuTimes.push_back((bench::now() - start) * 1000.0);
+				waitTimes.push_back(pacer.getLastWaitTime() * 1000.0);
+			}
+		}
+		readback.flush();
+		gpuProfiler.flush();
+		renderStats = renderer.getAverageStats();
+		if (tracePath)
+			profile = Profiler::getFrameReport(Profiler::getFrameIndex());
+		readbackStalls = readback.getStallCount();
+
+		GLCall(glFinish());
+		for (int i = 0; i < config.frames; i++) {
+			GLuint64 elapsed = 0;
+			GLCall(glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed));
+			gpuTimes.push_back(elapsed / 1000000.0);
+		}
+		GLCall(glDeleteQueries(config.frames, queries.data()));
+	}
+
+	if (tracePath && !Profiler::exportChromeTrace(tracePath, config.frames))
+		return -1;
+	if (glTracePath && !GLTracer::dump(glTracePath))
+		return -1;
+
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "scene");
+	json.member("renderer", (const char*)glGetString(GL_RENDERER));
+	json.member("version", (const char*)glGetString(GL_VERSION));
+	json.key("config");
+	json.beginObject();
+	json.member("quads", config.quads);
+	json.member("shaders", config.shaders);
+	json.member("uniforms", config.uniforms);
+	json.member("frames", config.frames);
+	json.member("warmup", config.warmup);
+	json.member("width", config.width);
+	json.member("height", config.height);
+	json.member("frames_in_flight", config.framesInFlight);
+	json.member("readback", config.readback);
+	json.member("seed", config.seed);
+	json.endObject();
+	json.stats("cpu_frame_ms", bench::Stats::compute(cpuTimes));
+	json.stats("gpu_frame_ms", bench::Stats::compute(gpuTimes));
+	json.stats("pacer_wait_ms", bench::Stats::compute(waitTimes));
+	json.key("render_stats");
+	json.beginObject();
+	json.member("draw_calls", renderStats.drawCalls);
+	json.member("triangles", renderStats.triangles);
+	json.member("vertex_array_binds", renderStats.vertexArrayBinds);
+	json.member("index_buffer_binds", renderStats.indexBufferBinds);
+	json.member("shader_binds", renderStats.shaderBinds);
+	json.member("texture_binds", renderStats.textureBinds);
+	json.member("sampler_binds", renderStats.samplerBinds);
+	json.member("uniform_updates", renderStats.uniformUpdates);
+	json.member("bytes_uploaded", renderStats.bytesUploaded);
+	json.endObject();
+	if (config.readback) {
+		json.member("readback_stalls", readbackStalls);
+		json.member("readback_checksum", readbackChecksum);
+	}
+	if (tracePath) {
+		json.key("last_frame_profile");
+		json.beginArray();
+		for (const ProfileReportEntry& entry : profile) {
+			json.beginObject();
+			json.member("track", entry.track);
+			json.member("name", entry.name);
+			json.member("depth", entry.depth);
+			json.member("calls", entry.calls);
+			json.member("ms", entry.milliseconds);
+			json.endObject();
+		}
+		json.endArray();
+	}
+	json.endObject();
+	bench::closeOutput(output);
+
+	return 0;
+}
@@ -0,0 +1,486 @@
+// Submission strategy benchmark: renders the same workload of many small meshes with
+// different draw submission techniques and reports CPU submit time, GPU time and draws/sec.
+//
+//   naive      - per object: set uniforms, bind its VertexArray/IndexBuffer, glDrawElements
+//   basevertex - all meshes merged into one VertexBuffer/IndexBuffer, bound once,
+//                per object: set uniforms, glDrawElementsBaseVertex
+//   instanced  - per mesh type: one glDrawElementsInstanced, per-object data as an instanced attribute
+//   indirect   - merged buffers + one glMultiDrawElementsIndirect using baseInstance
+//                (needs GL 4.3 or ARB_multi_draw_indirect + ARB_base_instance, skipped otherwise)
+//
+// usage: gl3FwEwSubmitBench [--objects N] [--frames F] [--warmup W] [--width X] [--height Y]
+//                           [--strategies naive,basevertex,instanced,indirect] [--csv] [--out file]
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "FramePacer.h"
+#include "BenchUtils.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MeshData {
+	std::vector<float> vertices;		// x, y
+	std::vector<unsigned int> indices;
+};
+
+// per object: offset.xy, scale, unused + color.rgba
+struct ObjectData {
+	float transform[4];
+	float color[4];
+};
+
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+struct StrategyResult {
+	std::string name;
+	bool supported;
+	int drawCalls;		// API draw calls per frame
+	bench::Stats submit;
+	bench::Stats gpu;
+	bench::Stats frame;
+	double objectsPerSecond;
+	unsigned int checksum;
+};
+
+static const int s_MeshTypes = 3;
+
+static MeshData makeMesh(int type)
+{
+	MeshData mesh;
+	// triangle, quad and hexagon fan: different sizes so merging needs real base vertices
+	int sides = type == 0 ? 3 : type == 1 ? 4 : 6;
+	bool fan = sides > 4;
+	if (fan) {
+		mesh.vertices.push_back(0.0f);
+		mesh.vertices.push_back(0.0f);
+	}
+	for (int i = 0; i < sides; i++) {
+		float angle = 6.2831853f * i / sides + 0.785398f;
+		mesh.vertices.push_back(cosf(angle));
+		mesh.vertices.push_back(sinf(angle));
+	}
+	if (fan) {
+		for (int i = 0; i < sides; i++) {
+			mesh.indices.push_back(0);
+			mesh.indices.push_back(1 + i);
+			mesh.indices.push_back(1 + (i + 1) % sides);
+		}
+	}
+	else {
+		for (int i = 1; i + 1 < sides; i++) {
+			mesh.indices.push_back(0);
+			mesh.indices.push_back(i);
+			mesh.indices.push_back(i + 1);
+		}
+	}
+	return mesh;
+}
+
+static ShaderProgramSources makeUniformShader()
+{
+	return {
+		"#version 330 core\n"
+		"layout(location = 0) in vec2 position;\n"
+		"uniform vec4 u_Transform;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = vec4(position * u_Transform.z + u_Transform.xy, 0.0, 1.0);\n"
+		"}\n",
+		"#version 330 core\n"
+		"layout(location = 0) out vec4 color;\n"
+		"uniform vec4 u_Color;\n"
+		"void main()\n"
+		"{\n"
+		"	color = u_Color;\n"
+		"}\n"
+	};
+}
+
+static ShaderProgramSources makeInstancedShader()
+{
+	return {
+		"#version 330 core\n"
+		"layout(location = 0) in vec2 position;\n"
+		"layout(location = 1) in vec4 transform;\n"
+		"layout(location = 2) in vec4 instanceColor;\n"
+		"out vec4 v_Color;\n"
+		"void main()\n"
+		"{\n"
+		"	v_Color = instanceColor;\n"
+		"	gl_Position = vec4(position * transform.z + transform.xy, 0.0, 1.0);\n"
+		"}\n",
+		"#version 330 core\n"
+		"layout(location = 0) out vec4 color;\n"
+		"in vec4 v_Color;\n"
+		"void main()\n"
+		"{\n"
+		"	color = v_Color;\n"
+		"}\n"
+	};
+}
+
+class Workload
+{
+public:
+	int objectCount;
+	std::vector<MeshData> meshes;
+	std::vector<ObjectData> objects;		// in draw order, grouped by mesh type
+	std::vector<int> objectMesh;
+
+	// per mesh type, for naive and instanced
+	std::vector<std::unique_ptr<VertexArray>> meshArrays;
+	std::vector<std::unique_ptr<VertexBuffer>> meshBuffers;
+	std::vector<std::unique_ptr<IndexBuffer>> meshIndices;
+
+	// everything merged, for basevertex and indirect
+	std::unique_ptr<VertexArray> mergedArray;
+	std::unique_ptr<VertexBuffer> mergedBuffer;
+	std::unique_ptr<IndexBuffer> mergedIndices;
+	std::vector<unsigned int> meshFirstIndex;
+	std::vector<int> meshBaseVertex;
+
+	// instance data: one VAO per mesh type for instancing, one for indirect
+	std::vector<std::unique_ptr<VertexArray>> instancedArrays;
+	std::unique_ptr<VertexBuffer> instanceBuffer;
+	std::vector<unsigned int> meshInstanceCount;
+	std::unique_ptr<VertexArray> indirectArray;
+	std::unique_ptr<VertexBuffer> objectBuffer;
+	unsigned int indirectBuffer;
+
+	std::unique_ptr<Shader> uniformShader;
+	std::unique_ptr<Shader> instancedShader;
+
+	Workload(int count, unsigned long long seed)
+		: objectCount(count), indirectBuffer(0)
+	{
+		bench::Random random(seed);
+		for (int i = 0; i < s_MeshTypes; i++)
+			meshes.push_back(makeMesh(i));
+
+		objects.resize(count);
+		objectMesh.resize(count);
+		for (int i = 0; i < count; i++) {
+			ObjectData& object = objects[i];
+			object.transform[0] = random.nextFloat(-0.98f, 0.98f);
+			object.transform[1] = random.nextFloat(-0.98f, 0.98f);
+			object.transform[2] = random.nextFloat(0.004f, 0.012f);
+			object.transform[3] = 0.0f;
+			for (int c = 0; c < 3; c++)
+				object.color[c] = random.nextFloat(0.2f, 1.0f);
+			object.color[3] = 1.0f;
+			objectMesh[i] = random.nextUInt() % s_MeshTypes;
+		}
+
+		// draw order grouped by mesh type, so every strategy produces the same image
+		std::vector<ObjectData> byType;
+		std::vector<int> byTypeMesh;
+		for (int type = 0; type < s_MeshTypes; type++) {
+			for (int i = 0; i < count; i++) {
+				if (objectMesh[i] == type) {
+					byType.push_back(objects[i]);
+					byTypeMesh.push_back(type);
+				}
+			}
+		}
+		objects.swap(byType);
+		objectMesh.swap(byTypeMesh);
+
+		uniformShader.reset(new Shader(makeUniformShader()));
+		instancedShader.reset(new Shader(makeInstancedShader()));
+
+		VertexBufferLayout positionLayout;
+		positionLayout.push<float>(2);
+		VertexBufferLayout instanceLayout;
+		instanceLayout.push<float>(4);
+		instanceLayout.push<float>(4);
+		instanceLayout.setDivisor(1);
+
+		// separate buffers per mesh type
+		for (int i = 0; i < s_MeshTypes; i++) {
+			const MeshData& mesh = meshes[i];
+			meshArrays.emplace_back(new VertexArray());
+			meshBuffers.emplace_back(new VertexBuffer(mesh.vertices.data(), (unsigned int)(mesh.vertices.size() * sizeof(float))));
+			meshArrays[i]->addBuffer(*meshBuffers[i], positionLayout);
+			meshIndices.emplace_back(new IndexBuffer(mesh.indices.data(), (unsigned int)mesh.indices.size()));
+		}
+
+		// merged geometry
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		for (const MeshData& mesh : meshes) {
+			meshFirstIndex.push_back((unsigned int)indices.size());
+			meshBaseVertex.push_back((int)(vertices.size() / 2));
+			vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+			indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());	// relative to the base vertex
+		}
+		mergedArray.reset(new VertexArray());
+		mergedBuffer.reset(new VertexBuffer(vertices.data(), (unsigned int)(vertices.size() * sizeof(float))));
+		mergedArray->addBuffer(*mergedBuffer, positionLayout);
+		mergedIndices.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+		mergedIndices->bind();	// the element buffer binding is part of the VAO state
+
+		// instance data, already grouped by mesh type
+		meshInstanceCount.assign(s_MeshTypes, 0);
+		for (int i = 0; i < count; i++)
+			meshInstanceCount[objectMesh[i]]++;
+		instanceBuffer.reset(new VertexBuffer(objects.data(), (unsigned int)(objects.size() * sizeof(ObjectData))));
+		unsigned int firstInstance = 0;
+		for (int type = 0; type < s_MeshTypes; type++) {
+			// GL 3.3 has no base instance, so each mesh type gets a VAO pointing into its slice
+			VertexArray* vertexArray = new VertexArray();
+			instancedArrays.emplace_back(vertexArray);
+			vertexArray->addBuffer(*meshBuffers[type], positionLayout);
+			addInstanceSlice(*vertexArray, *instanceBuffer, firstInstance);
+			meshIndices[type]->bind();
+			firstInstance += meshInstanceCount[type];
+		}
+
+		// indirect: merged geometry + per-object data addressed through baseInstance
+		if (isIndirectSupported()) {
+			indirectArray.reset(new VertexArray());
+			indirectArray->addBuffer(*mergedBuffer, positionLayout);
+			objectBuffer.reset(new VertexBuffer(objects.data(), (unsigned int)(objects.size() * sizeof(ObjectData))));
+			indirectArray->addBuffer(*objectBuffer, instanceLayout, indirectArray->getAttributeCount());
+			mergedIndices->bind();
+
+			std::vector<DrawElementsIndirectCommand> commands(count);
+			for (int i = 0; i < count; i++) {
+				int mesh = objectMesh[i];
+				commands[i].count = (GLuint)meshes[mesh].indices.size();
+				commands[i].instanceCount = 1;
+				commands[i].firstIndex = meshFirstIndex[mesh];
+				commands[i].baseVertex = meshBaseVertex[mesh];
+				commands[i].baseInstance = i;
+			}
+			GLCall(glGenBuffers(1, &indirectBuffer));
+			GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer));
+			GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW));
+			GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+		}
+		GLCall(glBindVertexArray(0));
+	}
+
+	~Workload()
+	{
+		if (indirectBuffer) {
+			GLCall(glDeleteBuffers(1, &indirectBuffer));
+		}
+	}
+
+	static bool isIndirectSupported()
+	{
+		return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+	}
+
+	// attributes 1 and 2 of the instanced shader, starting `first` instances into the buffer
+	static void addInstanceSlice(VertexArray& vertexArray, VertexBuffer& buffer, unsigned int first)
+	{
+		vertexArray.bind();
+		buffer.bind();
+		size_t offset = first * sizeof(ObjectData);
+		for (unsigned int i = 0; i < 2; i++) {
+			GLCall(glEnableVertexAttribArray(1 + i));
+			GLCall(glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, sizeof(ObjectData), (const void*)(offset + i * 4 * sizeof(float))));
+			GLCall(glVertexAttribDivisor(1 + i, 1));
+		}
+	}
+
+	// returns the number of API draw calls
+	int submit(const std::string& strategy)
+	{
+		if (strategy == "naive") {
+			uniformShader->bind();
+			for (int i = 0; i < objectCount; i++) {
+				const ObjectData& object = objects[i];
+				int mesh = objectMesh[i];
+				uniformShader->setUniform4f("u_Transform", object.transform[0], object.transform[1], object.transform[2], object.transform[3]);
+				uniformShader->setUniform4f("u_Color", object.color[0], object.color[1], object.color[2], object.color[3]);
+				meshArrays[mesh]->bind();
+				meshIndices[mesh]->bind();
+				GLCall(glDrawElements(GL_TRIANGLES, meshIndices[mesh]->getCount(), GL_UNSIGNED_INT, nullptr));
+			}
+			return objectCount;
+		}
+		if (strategy == "basevertex") {
+			uniformShader->bind();
+			mergedArray->bind();
+			for (int i = 0; i < objectCount; i++) {
+				const ObjectData& object = objects[i];
+				int mesh = objectMesh[i];
+				uniformShader->setUniform4f("u_Transform", object.transform[0], object.transform[1], object.transform[2], object.transform[3]);
+				uniformShader->setUniform4f("u_Color", object.color[0], object.color[1], object.color[2], object.color[3]);
+				GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)meshes[mesh].indices.size(), GL_UNSIGNED_INT,
+					(void*)(meshFirstIndex[mesh] * sizeof(unsigned int)), meshBaseVertex[mesh]));
+			}
+			return objectCount;
+		}
+		if (strategy == "instanced") {
+			instancedShader->bind();
+			for (int type = 0; type < s_MeshTypes; type++) {
+				instancedArrays[type]->bind();
+				GLCall(glDrawElementsInstanced(GL_TRIANGLES, meshIndices[type]->getCount(), GL_UNSIGNED_INT, nullptr, meshInstanceCount[type]));
+			}
+			return s_MeshTypes;
+		}
+		if (strategy == "indirect") {
+			instancedShader->bind();
+			indirectArray->bind();
+			GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer));
+			GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, objectCount, 0));
+			GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+			return 1;
+		}
+		return 0;
+	}
+};
+
+static unsigned int imageChecksum(int width, int height)
+{
+	std::vector<unsigned char> pixels(width * height * 4);
+	GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	for (unsigned char c : pixels)
+		hash = (hash ^ c) * 16777619u;
+	return hash;
+}
+
+static StrategyResult runStrategy(Workload& workload, const std::string& strategy, int frames, int warmup, int width, int height)
+{
+	StrategyResult result;
+	result.name = strategy;
+	result.supported = strategy != "indirect" || Workload::isIndirectSupported();
+	result.drawCalls = 0;
+	result.objectsPerSecond = 0.0;
+	result.checksum = 0;
+	if (!result.supported)
+		return result;
+
+	std::vector<unsigned int> queries(frames);
+	GLCall(glGenQueries(frames, queries.data()));
+	std::vector<double> submitTimes, frameTimes, gpuTimes;
+
+	FramePacer pacer(2);
+	for (int frame = 0; frame < warmup + frames; frame++) {
+		bool measured = frame >= warmup;
+		double frameStart = bench::now();
+		pacer.beginFrame();
+
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		if (measured) {
+			GLCall(glBeginQuery(GL_TIME_ELAPSED, queries[frame - warmup]));
+		}
+
+		double submitStart = bench::now();
+		result.drawCalls = workload.submit(strategy);
+		double submitEnd = bench::now();
+
+		if (measured) {
+			GLCall(glEndQuery(GL_TIME_ELAPSED));
+		}
+		GLCall(glFlush());
+		pacer.endFrame();
+
+		if (measured) {
+			submitTimes.push_back((submitEnd - submitStart) * 1000.0);
+			frameTimes.push_back((bench::now() - frameStart) * 1000.0);
+		}
+	}
+
+	GLCall(glFinish());
+	for (int i = 0; i < frames; i++) {
+		GLuint64 elapsed = 0;
+		GLCall(glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed));
+		gpuTimes.push_back(elapsed / 1000000.0);
+	}
+	GLCall(glDeleteQueries(frames, queries.data()));
+
+	result.submit = bench::Stats::compute(submitTimes);
+	result.gpu = bench::Stats::compute(gpuTimes);
+	result.frame = bench::Stats::compute(frameTimes);
+	// the slower of CPU and GPU bounds the throughput
+	double frameSeconds = std::max(result.frame.mean, result.gpu.mean) / 1000.0;
+	result.objectsPerSecond = frameSeconds > 0.0 ? workload.objectCount / frameSeconds : 0.0;
+	result.checksum = imageChecksum(width, height);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int objects = (int)bench::getArg(argc, argv, "--objects", 50000LL);
+	int frames = (int)bench::getArg(argc, argv, "--frames", 100LL);
+	int warmup = (int)bench::getArg(argc, argv, "--warmup", 10LL);
+	int width = (int)bench::getArg(argc, argv, "--width", 1280LL);
+	int height = (int)bench::getArg(argc, argv, "--height", 720LL);
+	unsigned long long seed = (unsigned long long)bench::getArg(argc, argv, "--seed", 1LL);
+	std::vector<std::string> strategies = bench::splitList(bench::getArg(argc, argv, "--strategies", "naive,basevertex,instanced,indirect"));
+	bool csv = bench::hasArg(argc, argv, "--csv");
+	if (objects < 1) objects = 1;
+	if (frames < 1) frames = 1;
+
+	HeadlessContext context(width, height);
+	if (!context.isValid())
+		return -1;
+
+	std::vector<StrategyResult> results;
+	{
+		Workload workload(objects, seed);
+		for (const std::string& strategy : strategies)
+			results.push_back(runStrategy(workload, strategy, frames, warmup, width, height));
+	}
+
+	FILE* output = bench::openOutput(argc, argv);
+	if (csv) {
+		fprintf(output, "renderer,strategy,supported,objects,draw_calls,submit_ms_mean,submit_ms_p95,gpu_ms_mean,gpu_ms_p95,frame_ms_mean,frame_ms_p95,objects_per_sec,checksum\n");
+		for (const StrategyResult& r : results) {
+			fprintf(output, "\"%s\",%s,%d,%d,%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%08x\n",
+				(const char*)glGetString(GL_RENDERER), r.name.c_str(), r.supported ? 1 : 0, objects, r.drawCalls,
+				r.submit.mean, r.submit.p95, r.gpu.mean, r.gpu.p95, r.frame.mean, r.frame.p95, r.objectsPerSecond, r.checksum);
+		}
+	}
+	else {
+		bench::JsonWriter json(output);
+		json.beginObject();
+		json.member("benchmark", "submission");
+		json.member("renderer", (const char*)glGetString(GL_RENDERER));
+		json.member("version", (const char*)glGetString(GL_VERSION));
+		json.member("objects", objects);
+		json.member("frames", frames);
+		json.key("results");
+		json.beginArray();
+		for (const StrategyResult& r : results) {
+			json.beginObject();
+			json.member("strategy", r.name);
+			json.member("supported", r.supported);
+			if (r.supported) {
+				json.member("draw_calls", r.drawCalls);
+				json.stats("submit_ms", r.submit);
+				json.stats("gpu_ms", r.gpu);
+				json.stats("frame_ms", r.frame);
+				json.member("objects_per_sec", r.objectsPerSecond);
+				char checksum[16];
+				snprintf(checksum, sizeof(checksum), "%08x", r.checksum);
+				json.member("checksum", checksum);
+			}
+			json.endObject();
+		}
+		json.endArray();
+		json.endObject();
+	}
+	bench::closeOutput(output);
+
+	return 0;
+}
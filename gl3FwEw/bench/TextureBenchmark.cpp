@@ -0,0 +1,304 @@
+// Texture load benchmark: loads a set of generated images while a frame loop keeps drawing
+// them, and reports how much the loading shows up in the frame times.
+//
+//   sync  - read, decode and glTexImage on the render thread in one frame, like a blocking level load
+//   async - TextureLoader: worker decode, PBO upload under --budget-kb per frame
+//   dds   - TextureFile: BC1 DDS files with a full mip chain, mapped and uploaded compressed
+//   dds-decode - the same files through the software BC1 decode, as on a driver without S3TC
+//   stream - the same files through TextureStreamer: mip tails first, then only the levels the
+//            on-screen size needs, under --vram-mb and --budget-kb per frame
+//
+// max_frame_ms is the hitch; load_ms is from the first load request until the last texture is
+// Ready; vram_bytes is what the textures allocate. The dds modes use their own (random block)
+// images, their checksums only compare with each other (stream matches dds: the levels it
+// leaves out are finer than the sampler reads).
+//
+// usage: gl3FwEwTextureBench [--images N] [--size S] [--budget-kb K] [--workers W] [--frames F]
+//                            [--modes sync,async,dds,dds-decode,stream] [--vram-mb M]
+//                            [--dir path] [--out file.json]
+//   --size: images are S x S, written to --dir (default .) as bench_texture_<i>.tga / .dds
+//   shaders are loaded from res/shaders/, run it from gl3FwEw/
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "SpriteRenderer.h"
+#include "BatchRenderer.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "ImageDecoder.h"
+#include "TextureFile.h"
+#include "TextureStreamer.h"
+#include "FramePacer.h"
+#include "BenchUtils.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ModeResult {
+	std::string mode;
+	bench::Stats frame;
+	double maxFrameMs;
+	double loadMs;
+	unsigned int framesToLoad;
+	unsigned int loaded;
+	unsigned long long vramBytes;
+	unsigned int checksum;		// of the last frame, equal across modes once everything loaded
+};
+
+static bool writeImages(const std::vector<std::string>& paths, unsigned int size)
+{
+	std::vector<unsigned char> pixels((size_t)size * size * 4);
+	for (size_t i = 0; i < paths.size(); i++) {
+		bench::Random random((unsigned int)i + 1);
+		for (size_t p = 0; p < pixels.size(); p++)
+			pixels[p] = (unsigned char)random.nextUInt();
+		if (!ImageDecoder::writeTga(paths[i].c_str(), pixels.data(), size, size)) {
+			fprintf(stderr, "can't write %s\n", paths[i].c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+// random blocks: any 8 bytes are a valid BC1 block
+static bool writeDdsImages(const std::vector<std::string>& paths, unsigned int size)
+{
+	unsigned int levels = Texture::getMaxLevels(size, size);
+	std::vector<unsigned char> blocks;
+	for (unsigned int level = 0; level < levels; level++) {
+		unsigned int levelSize = size >> level > 0 ? size >> level : 1;
+		blocks.resize(blocks.size() + Texture::getImageSize(TextureFormat::BC1, levelSize, levelSize));
+	}
+	for (size_t i = 0; i < paths.size(); i++) {
+		bench::Random random((unsigned int)i + 1);
+		for (size_t p = 0; p < blocks.size(); p++)
+			blocks[p] = (unsigned char)random.nextUInt();
+		TextureFileInfo info = { TextureFormat::BC1, size, size, {} };
+		const unsigned char* data = blocks.data();
+		for (unsigned int level = 0; level < levels; level++) {
+			unsigned int levelSize = size >> level > 0 ? size >> level : 1;
+			unsigned int bytes = Texture::getImageSize(TextureFormat::BC1, levelSize, levelSize);
+			info.levels.push_back({ data, bytes });
+			data += bytes;
+		}
+		if (!TextureFile::writeDds(paths[i].c_str(), info)) {
+			fprintf(stderr, "can't write %s\n", paths[i].c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+static unsigned int imageChecksum(int width, int height)
+{
+	std::vector<unsigned char> pixels(width * height * 4);
+	GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	unsigned int hash = 2166136261u;
+	for (unsigned char c : pixels)
+		hash = (hash ^ c) * 16777619u;
+	return hash;
+}
+
+// the blocking path the loader replaces: everything on the render thread
+static Texture2D* loadNow(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return nullptr;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	std::vector<unsigned char> data(size > 0 ? size : 1);
+	size_t read = size > 0 ? fread(data.data(), 1, size, file) : 0;
+	fclose(file);
+
+	ImageInfo info;
+	if (!ImageDecoder::readInfo(data.data(), read, info))
+		return nullptr;
+	std::vector<unsigned char> pixels((size_t)info.width * info.height * 4);
+	if (!ImageDecoder::decode(data.data(), read, info, pixels.data()))
+		return nullptr;
+	return new Texture2D(info.width, info.height, pixels.data());
+}
+
+static ModeResult runMode(const std::string& mode, const std::vector<std::string>& paths, Renderer& renderer,
+	SpriteRenderer& sprites, const float* projection, int frames, unsigned int budget, unsigned int workers,
+	unsigned long long vramBudget, int width, int height)
+{
+	ModeResult result = {};
+	result.mode = mode;
+
+	std::unique_ptr<TextureLoader> loader;
+	std::vector<TextureLoader::Handle> handles;
+	std::vector<std::unique_ptr<Texture2D>> textures;
+	std::unique_ptr<TextureStreamer> streamer;
+	std::vector<TextureStreamer::Handle> streamed;
+	if (mode == "async")
+		loader.reset(new TextureLoader(workers, budget));
+	else if (mode == "stream")
+		streamer.reset(new TextureStreamer(vramBudget, budget));
+
+	const int loadFrame = 10;	// a few quiet frames first
+	double loadStart = 0.0;
+	std::vector<double> frameTimes;
+	FramePacer pacer(2);
+	for (int frame = 0; frame < frames; frame++) {
+		double frameStart = bench::now();
+		pacer.beginFrame();
+
+		if (frame == loadFrame) {
+			loadStart = frameStart;
+			for (const std::string& path : paths) {
+				if (loader)
+					handles.push_back(loader->load(path));
+				else if (streamer)
+					streamed.push_back(streamer->load(path));
+				else if (mode == "sync")
+					textures.emplace_back(loadNow(path));
+				else
+					textures.emplace_back(TextureFile::load(path, mode == "dds"));
+			}
+		}
+		float cell = (float)width / (paths.size() > 0 ? paths.size() : 1);
+		if (loader)
+			loader->update();
+		if (streamer) {
+			for (TextureStreamer::Handle handle : streamed)
+				streamer->reportUsage(handle, cell);
+			streamer->update();
+		}
+
+		renderer.clear();
+		sprites.begin(projection);
+		for (size_t i = 0; i < paths.size(); i++) {
+			const Texture2D* texture = nullptr;
+			if (loader && i < handles.size())
+				texture = &loader->get(handles[i]);
+			else if (streamer && i < streamed.size())
+				texture = &streamer->get(streamed[i]);
+			else if (i < textures.size())
+				texture = textures[i].get();
+			sprites.drawSprite(i * cell, 0.0f, cell, cell, texture);
+		}
+		sprites.end();
+
+		GLCall(glFlush());
+		pacer.endFrame();
+		renderer.endFrame();
+		double frameEnd = bench::now();
+		frameTimes.push_back((frameEnd - frameStart) * 1000.0);
+
+		bool loaded = frame >= loadFrame && (loader ? loader->getPendingCount() == 0 : true);
+		for (size_t i = 0; streamer && i < streamed.size(); i++)
+			loaded = loaded && streamer->getResidentLevel(streamed[i]) == streamer->getWantedLevel(streamed[i]);
+		if (loaded && result.framesToLoad == 0) {
+			result.framesToLoad = frame - loadFrame + 1;
+			result.loadMs = (frameEnd - loadStart) * 1000.0;
+		}
+	}
+	GLCall(glFinish());
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		bool ready = loader ? i < handles.size() && loader->getState(handles[i]) == TextureLoadState::Ready
+			: streamer ? i < streamed.size() && streamed[i] != TextureStreamer::InvalidHandle
+			: i < textures.size() && textures[i];
+		result.loaded += ready ? 1 : 0;
+		if (ready && !streamer)
+			result.vramBytes += loader ? loader->get(handles[i]).getByteSize() : textures[i]->getByteSize();
+	}
+	if (streamer)
+		result.vramBytes = streamer->getResidentBytes();
+	result.frame = bench::Stats::compute(frameTimes);
+	result.maxFrameMs = result.frame.max;
+	result.checksum = imageChecksum(width, height);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int imageCount = (int)bench::getArg(argc, argv, "--images", 8LL);
+	int size = (int)bench::getArg(argc, argv, "--size", 1024LL);
+	unsigned int budget = (unsigned int)bench::getArg(argc, argv, "--budget-kb", (long long)(TextureLoader::DefaultBytesPerFrame / 1024)) * 1024;
+	unsigned int workers = (unsigned int)bench::getArg(argc, argv, "--workers", (long long)TextureLoader::DefaultWorkers);
+	int frames = (int)bench::getArg(argc, argv, "--frames", 120LL);
+	unsigned long long vramBudget = (unsigned long long)bench::getArg(argc, argv, "--vram-mb", (long long)(TextureStreamer::DefaultBudget >> 20)) << 20;
+	std::string dir = bench::getArg(argc, argv, "--dir", ".");
+	std::vector<std::string> modes = bench::splitList(bench::getArg(argc, argv, "--modes", "sync,async,dds,dds-decode,stream"));
+	const int width = 1024, height = 256;
+	if (imageCount < 1) imageCount = 1;
+	if (size < 1) size = 1;
+	if (frames < 20) frames = 20;
+
+	std::vector<std::string> paths, ddsPaths;
+	for (int i = 0; i < imageCount; i++) {
+		paths.push_back(dir + "/bench_texture_" + std::to_string(i) + ".tga");
+		ddsPaths.push_back(dir + "/bench_texture_" + std::to_string(i) + ".dds");
+	}
+	if (!writeImages(paths, size) || !writeDdsImages(ddsPaths, size))
+		return 1;
+
+	HeadlessContext context(width, height);
+	if (!context.isValid())
+		return 1;
+	context.bind();
+
+	std::vector<ModeResult> results;
+	{
+		Renderer renderer;
+		Shader shader("res/shaders/sprite.shader");
+		SpriteRenderer sprites(renderer, shader);
+		float projection[16];
+		BatchRenderer::ortho(0.0f, (float)width, 0.0f, (float)height, projection);
+		for (const std::string& mode : modes) {
+			if (mode == "sync" || mode == "async")
+				results.push_back(runMode(mode, paths, renderer, sprites, projection, frames, budget, workers, vramBudget, width, height));
+			else if (mode == "dds" || mode == "dds-decode" || mode == "stream")
+				results.push_back(runMode(mode, ddsPaths, renderer, sprites, projection, frames, budget, workers, vramBudget, width, height));
+			else
+				fprintf(stderr, "unknown mode %s\n", mode.c_str());
+		}
+	}
+	for (const std::string& path : paths)
+		remove(path.c_str());
+	for (const std::string& path : ddsPaths)
+		remove(path.c_str());
+
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "texture");
+	json.member("renderer", (const char*)glGetString(GL_RENDERER));
+	json.member("version", (const char*)glGetString(GL_VERSION));
+	json.key("config");
+	json.beginObject();
+	json.member("images", imageCount);
+	json.member("size", size);
+	json.member("budget_bytes", budget);
+	json.member("workers", workers);
+	json.member("vram_budget_bytes", vramBudget);
+	json.member("frames", frames);
+	json.member("immutable_storage", Texture::hasImmutableStorage());
+	json.member("s3tc", Texture::isSupported(TextureFormat::BC1));
+	json.endObject();
+	json.key("results");
+	json.beginArray();
+	for (const ModeResult& result : results) {
+		json.beginObject();
+		json.member("mode", result.mode);
+		json.stats("frame_ms", result.frame);
+		json.member("max_frame_ms", result.maxFrameMs);
+		json.member("load_ms", result.loadMs);
+		json.member("frames_to_load", result.framesToLoad);
+		json.member("loaded", result.loaded);
+		json.member("vram_bytes", result.vramBytes);
+		json.member("checksum", result.checksum);
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	bench::closeOutput(output);
+	return 0;
+}
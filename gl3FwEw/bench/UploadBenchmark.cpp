@@ -0,0 +1,260 @@
+// Buffer upload benchmark: streams a payload into a vertex buffer every frame through
+// each upload path, consumes it with a draw, and reports throughput and frame stalls.
+//
+//   bufferdata - glBufferData(size, data) every frame (driver orphans and copies)
+//   subdata    - VertexBuffer::setData, i.e. glBufferSubData into a buffer the GPU may still read
+//   orphan     - glBufferData(size, nullptr) then glBufferSubData
+//   map        - glMapBufferRange with GL_MAP_INVALIDATE_BUFFER_BIT + memcpy
+//   unsync     - 3-section ring, glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT, fenced per section
+//   persistent - 3-section ring in glBufferStorage memory mapped once (GL 4.4 / ARB_buffer_storage)
+//
+// usage: gl3FwEwUploadBench [--sizes 65536,1048576,8388608] [--frames F] [--warmup W]
+//                           [--paths bufferdata,subdata,...] [--out file.json]
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "VertexBuffer.h"
+#include "Shader.h"
+#include "BenchUtils.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const unsigned int s_RingSections = 3;
+
+struct PathResult {
+	std::string path;
+	unsigned int size;
+	bool supported;
+	bench::Stats upload;		// ms spent in the upload calls
+	bench::Stats frame;			// ms per frame, upload + draw + flush
+	double uploadGBps;
+	double effectiveGBps;
+	int stalledFrames;			// frames slower than twice the median
+	double fenceWaitMs;			// total time blocked on ring fences
+};
+
+static ShaderProgramSources makeConsumeShader()
+{
+	// touches every vec4 of the payload; rasterization is disabled so only the fetch costs
+	return {
+		"#version 330 core\n"
+		"layout(location = 0) in vec4 payload;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = payload;\n"
+		"}\n",
+		"#version 330 core\n"
+		"layout(location = 0) out vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"	color = vec4(1.0);\n"
+		"}\n"
+	};
+}
+
+static bool isPersistentSupported()
+{
+	return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+// waits for a ring section's fence, returns the seconds spent waiting
+static double waitFence(GLsync& fence)
+{
+	if (!fence)
+		return 0.0;
+
+	double start = bench::now();
+	while (true) {
+		GLCall(GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000));
+		if (result != GL_TIMEOUT_EXPIRED)
+			break;
+	}
+	GLCall(glDeleteSync(fence));
+	fence = nullptr;
+	return bench::now() - start;
+}
+
+static PathResult runPath(const std::string& path, unsigned int size, int frames, int warmup, const std::vector<unsigned char>& payload)
+{
+	PathResult result;
+	result.path = path;
+	result.size = size;
+	result.supported = path != "persistent" || isPersistentSupported();
+	result.uploadGBps = result.effectiveGBps = 0.0;
+	result.stalledFrames = 0;
+	result.fenceWaitMs = 0.0;
+	if (!result.supported)
+		return result;
+
+	bool ring = path == "unsync" || path == "persistent";
+	unsigned int bufferSize = ring ? size * s_RingSections : size;
+
+	// the dynamic VertexBuffer is the allocation every path starts from, except persistent storage
+	std::unique_ptr<VertexBuffer> dynamicBuffer;
+	unsigned int buffer = 0;
+	void* persistentMemory = nullptr;
+	if (path == "persistent") {
+		GLCall(glGenBuffers(1, &buffer));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags));
+		GLCall(persistentMemory = glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+	}
+	else {
+		dynamicBuffer.reset(new VertexBuffer(bufferSize));
+		buffer = dynamicBuffer->getRendererID();
+	}
+
+	unsigned int vertexArray;
+	GLCall(glGenVertexArrays(1, &vertexArray));
+	GLCall(glBindVertexArray(vertexArray));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+	GLCall(glEnableVertexAttribArray(0));
+
+	GLsync fences[s_RingSections] = {};
+	std::vector<double> uploadTimes, frameTimes;
+	double fenceWait = 0.0;
+	GLsizei points = size / 16;
+
+	for (int frame = 0; frame < warmup + frames; frame++) {
+		bool measured = frame >= warmup;
+		unsigned int section = frame % s_RingSections;
+		unsigned int offset = ring ? section * size : 0;
+
+		double frameStart = bench::now();
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+
+		// ring paths must not overwrite a section the GPU is still reading
+		double waited = ring ? waitFence(fences[section]) : 0.0;
+
+		double uploadStart = bench::now();
+		if (path == "bufferdata") {
+			GLCall(glBufferData(GL_ARRAY_BUFFER, size, payload.data(), GL_STREAM_DRAW));
+		}
+		else if (path == "subdata") {
+			dynamicBuffer->setData(payload.data(), size);
+		}
+		else if (path == "orphan") {
+			GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW));
+			GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, payload.data()));
+		}
+		else if (path == "map") {
+			GLCall(void* memory = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+			memcpy(memory, payload.data(), size);
+			GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+		}
+		else if (path == "unsync") {
+			GLCall(void* memory = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+			memcpy(memory, payload.data(), size);
+			GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+		}
+		else if (path == "persistent") {
+			memcpy((unsigned char*)persistentMemory + offset, payload.data(), size);
+		}
+		double uploadEnd = bench::now();
+
+		GLCall(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 16, (const void*)(size_t)offset));
+		GLCall(glDrawArrays(GL_POINTS, 0, points));
+		if (ring) {
+			GLCall(fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		}
+		GLCall(glFlush());
+
+		if (measured) {
+			uploadTimes.push_back((uploadEnd - uploadStart) * 1000.0);
+			frameTimes.push_back((bench::now() - frameStart) * 1000.0);
+			fenceWait += waited;
+		}
+	}
+	GLCall(glFinish());
+
+	for (unsigned int i = 0; i < s_RingSections; i++)
+		waitFence(fences[i]);
+	GLCall(glBindVertexArray(0));
+	GLCall(glDeleteVertexArrays(1, &vertexArray));
+	if (path == "persistent") {
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+		GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+		GLCall(glDeleteBuffers(1, &buffer));
+	}
+
+	result.upload = bench::Stats::compute(uploadTimes);
+	result.frame = bench::Stats::compute(frameTimes);
+	result.uploadGBps = result.upload.mean > 0.0 ? size / (result.upload.mean / 1000.0) / 1e9 : 0.0;
+	result.effectiveGBps = result.frame.mean > 0.0 ? size / (result.frame.mean / 1000.0) / 1e9 : 0.0;
+	for (double frameTime : frameTimes)
+		if (frameTime > 2.0 * result.frame.p50)
+			result.stalledFrames++;
+	result.fenceWaitMs = fenceWait * 1000.0;
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> sizes = bench::splitList(bench::getArg(argc, argv, "--sizes", "65536,1048576,8388608"));
+	std::vector<std::string> paths = bench::splitList(bench::getArg(argc, argv, "--paths", "bufferdata,subdata,orphan,map,unsync,persistent"));
+	int frames = (int)bench::getArg(argc, argv, "--frames", 200LL);
+	int warmup = (int)bench::getArg(argc, argv, "--warmup", 20LL);
+	if (frames < 1) frames = 1;
+
+	HeadlessContext context(64, 64);
+	if (!context.isValid())
+		return -1;
+
+	std::vector<PathResult> results;
+	{
+		Shader shader(makeConsumeShader());
+		shader.bind();
+		GLCall(glEnable(GL_RASTERIZER_DISCARD));
+
+		for (const std::string& sizeText : sizes) {
+			// whole vec4s only
+			unsigned int size = (unsigned int)strtoul(sizeText.c_str(), nullptr, 10) & ~15u;
+			if (size == 0)
+				continue;
+
+			std::vector<unsigned char> payload(size);
+			bench::Random random(size);
+			for (unsigned int i = 0; i < size; i++)
+				payload[i] = (unsigned char)random.nextUInt();
+
+			for (const std::string& path : paths)
+				results.push_back(runPath(path, size, frames, warmup, payload));
+		}
+
+		GLCall(glDisable(GL_RASTERIZER_DISCARD));
+	}
+
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "upload");
+	json.member("renderer", (const char*)glGetString(GL_RENDERER));
+	json.member("version", (const char*)glGetString(GL_VERSION));
+	json.member("frames", frames);
+	json.key("results");
+	json.beginArray();
+	for (const PathResult& r : results) {
+		json.beginObject();
+		json.member("path", r.path);
+		json.member("bytes", r.size);
+		json.member("supported", r.supported);
+		if (r.supported) {
+			json.stats("upload_ms", r.upload);
+			json.stats("frame_ms", r.frame);
+			json.member("upload_gbps", r.uploadGBps);
+			json.member("effective_gbps", r.effectiveGBps);
+			json.member("stalled_frames", r.stalledFrames);
+			json.member("fence_wait_ms", r.fenceWaitMs);
+		}
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	bench::closeOutput(output);
+
+	return 0;
+}
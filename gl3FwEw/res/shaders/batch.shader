@@ -0,0 +1,59 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 a_Position;
+layout(location = 1) in vec2 a_TexCoord;
+layout(location = 2) in vec4 a_Color;
+layout(location = 3) in float a_TexSlot;
+
+uniform mat4 u_ViewProjection;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+flat out int v_TexSlot;
+
+void main()
+{
+	v_TexCoord = a_TexCoord;
+	v_Color = a_Color;
+	v_TexSlot = int(a_TexSlot);
+	gl_Position = u_ViewProjection * vec4(a_Position, 0.0, 1.0);
+};
+
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+flat in int v_TexSlot;
+
+// BatchRenderer::MaxTextureSlots
+uniform sampler2D u_Textures[16];
+
+void main()
+{
+	// GLSL 3.30 only indexes sampler arrays with constants
+	vec4 texel;
+	switch (v_TexSlot) {
+		case 0:  texel = texture(u_Textures[0], v_TexCoord); break;
+		case 1:  texel = texture(u_Textures[1], v_TexCoord); break;
+		case 2:  texel = texture(u_Textures[2], v_TexCoord); break;
+		case 3:  texel = texture(u_Textures[3], v_TexCoord); break;
+		case 4:  texel = texture(u_Textures[4], v_TexCoord); break;
+		case 5:  texel = texture(u_Textures[5], v_TexCoord); break;
+		case 6:  texel = texture(u_Textures[6], v_TexCoord); break;
+		case 7:  texel = texture(u_Textures[7], v_TexCoord); break;
+		case 8:  texel = texture(u_Textures[8], v_TexCoord); break;
+		case 9:  texel = texture(u_Textures[9], v_TexCoord); break;
+		case 10: texel = texture(u_Textures[10], v_TexCoord); break;
+		case 11: texel = texture(u_Textures[11], v_TexCoord); break;
+		case 12: texel = texture(u_Textures[12], v_TexCoord); break;
+		case 13: texel = texture(u_Textures[13], v_TexCoord); break;
+		case 14: texel = texture(u_Textures[14], v_TexCoord); break;
+		default: texel = texture(u_Textures[15], v_TexCoord); break;
+	}
+	color = texel * v_Color;
+};
@@ -0,0 +1,46 @@
+#shader vertex
+#version 330 core
+
+// one SpriteInstance per instance, no per-vertex attributes
+layout(location = 0) in vec4 a_Rect;		// x, y of the lower left corner, width, height
+layout(location = 1) in vec4 a_TexRect;		// u0, v0, u1, v1
+layout(location = 2) in vec4 a_Color;
+layout(location = 3) in float a_Rotation;	// radians, around the center
+
+uniform mat4 u_ViewProjection;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+
+void main()
+{
+	// triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 position = a_Rect.xy + corner * a_Rect.zw;
+	if (a_Rotation != 0.0) {
+		vec2 offset = (corner - 0.5) * a_Rect.zw;
+		float s = sin(a_Rotation);
+		float c = cos(a_Rotation);
+		position = a_Rect.xy + 0.5 * a_Rect.zw + vec2(c * offset.x - s * offset.y, s * offset.x + c * offset.y);
+	}
+
+	v_TexCoord = mix(a_TexRect.xy, a_TexRect.zw, corner);
+	v_Color = a_Color;
+	gl_Position = u_ViewProjection * vec4(position, 0.0, 1.0);
+};
+
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+
+uniform sampler2D u_Texture;
+
+void main()
+{
+	color = texture(u_Texture, v_TexCoord) * v_Color;
+};
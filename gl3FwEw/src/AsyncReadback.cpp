@@ -0,0 +1,98 @@
+#include "AsyncReadback.h"
+#include "Renderer.h"
+#include "Profiler.h"
+
+AsyncReadback::AsyncReadback(unsigned int slotCount)
+	: m_Head(0), m_Tail(0), m_Pending(0), m_Stalls(0)
+{
+	if (slotCount < 1)
+		slotCount = 1;
+
+	m_Slots.resize(slotCount);
+	for (Slot& slot : m_Slots) {
+		GLCall(glGenBuffers(1, &slot.buffer));
+		slot.size = 0;
+		slot.fence = nullptr;
+		slot.width = slot.height = 0;
+	}
+}
+
+AsyncReadback::~AsyncReadback()
+{
+	// drop whatever is still in flight, nobody is around to receive it
+	for (Slot& slot : m_Slots) {
+		if (slot.fence) {
+			GLCall(glDeleteSync(slot.fence));
+		}
+		GLCall(glDeleteBuffers(1, &slot.buffer));
+	}
+}
+
+void AsyncReadback::capture(int x, int y, int width, int height, Callback callback)
+{
+	PROFILE_SCOPE("AsyncReadback::capture");
+	Slot& slot = m_Slots[m_Head];
+	if (slot.fence) {
+		// ring is full: the slot we want is the oldest one in flight
+		m_Stalls++;
+		complete(slot);
+	}
+
+	unsigned int size = width * height * 4;
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+	if (slot.size != size) {
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ));
+		slot.size = size;
+	}
+
+	// with a pack buffer bound the last argument is an offset, the call returns right away
+	GLCall(glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	GLCall(slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+	slot.width = width;
+	slot.height = height;
+	slot.callback = callback;
+
+	m_Head = (m_Head + 1) % m_Slots.size();
+	m_Pending++;
+}
+
+void AsyncReadback::update()
+{
+	while (m_Pending > 0 && isReady(m_Slots[m_Tail], 0))
+		complete(m_Slots[m_Tail]);
+}
+
+void AsyncReadback::flush()
+{
+	while (m_Pending > 0)
+		complete(m_Slots[m_Tail]);
+}
+
+bool AsyncReadback::isReady(Slot& slot, GLuint64 timeout)
+{
+	GLCall(GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout));
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED;
+}
+
+void AsyncReadback::complete(Slot& slot)
+{
+	PROFILE_SCOPE("AsyncReadback::complete");
+	// slots complete in order, so this is always the tail
+	while (!isReady(slot, 100000000));	// 100 ms
+
+	GLCall(glDeleteSync(slot.fence));
+	slot.fence = nullptr;
+
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+	GLCall(const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT));
+	if (pixels && slot.callback)
+		slot.callback(pixels, slot.width, slot.height);
+	GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	slot.callback = nullptr;
+	m_Tail = (m_Tail + 1) % m_Slots.size();
+	m_Pending--;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <functional>
+#include <vector>
+
+// Reads the framebuffer back to the CPU without stalling the render loop.
+// capture() queues a glReadPixels into one of N pixel pack buffers and fences it;
+// update() hands the mapped pixels to the callback once the GPU is done, usually
+// a couple of frames later. Pixels are tightly packed RGBA8, bottom row first.
+class AsyncReadback
+{
+public:
+	typedef std::function<void(const unsigned char* pixels, int width, int height)> Callback;
+
+private:
+	struct Slot {
+		unsigned int buffer;
+		unsigned int size;		// bytes allocated for the buffer
+		GLsync fence;			// non-null while a readback is in flight
+		int width;
+		int height;
+		Callback callback;
+	};
+
+	std::vector<Slot> m_Slots;
+	unsigned int m_Head;		// next slot to capture into
+	unsigned int m_Tail;		// oldest slot in flight
+	unsigned int m_Pending;
+	unsigned int m_Stalls;
+
+	void complete(Slot& slot);
+	bool isReady(Slot& slot, GLuint64 timeout);
+
+public:
+	AsyncReadback(unsigned int slotCount = 3);
+	~AsyncReadback();
+
+	// reads from the currently bound read framebuffer; if all slots are busy
+	// the oldest capture is completed first (counted as a stall)
+	void capture(int x, int y, int width, int height, Callback callback);
+	// delivers every capture the GPU already finished, never blocks
+	void update();
+	// blocks until all captures are delivered
+	void flush();
+
+	inline unsigned int getPendingCount() const { return m_Pending; }
+	inline unsigned int getStallCount() const { return m_Stalls; }
+};
@@ -0,0 +1,161 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Profiler.h"
+
+static const float s_IdentityMatrix[16] = {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f
+};
+
+static const float s_FullTexture[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+BatchRenderer::BatchRenderer(const Renderer& renderer, Shader& shader, unsigned int maxQuads)
+	: m_Renderer(renderer), m_Shader(shader), m_MaxQuads(maxQuads > 0 ? maxQuads : 1),
+	m_QuadCount(0), m_TextureSlotCount(1), m_Stats()
+{
+	m_Vertices.resize(m_MaxQuads * 4);
+
+	// the same 6 indices for every quad, the vertices are what changes
+	std::vector<unsigned int> indices(m_MaxQuads * 6);
+	for (unsigned int quad = 0; quad < m_MaxQuads; quad++) {
+		unsigned int* index = &indices[quad * 6];
+		unsigned int first = quad * 4;
+		index[0] = first + 0;
+		index[1] = first + 1;
+		index[2] = first + 2;
+		index[3] = first + 2;
+		index[4] = first + 3;
+		index[5] = first + 0;
+	}
+
+	VertexBufferLayout layout;
+	layout.push<float>(2);			// position
+	layout.push<float>(2);			// texCoord
+	layout.push<unsigned char>(4);	// color
+	layout.push<float>(1);			// texSlot
+
+	m_VertexArray.reset(new VertexArray());
+	m_VertexBuffer.reset(new VertexBuffer(m_MaxQuads * 4 * (unsigned int)sizeof(BatchVertex)));
+	m_VertexArray->addBuffer(*m_VertexBuffer, layout);
+	m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+	unsigned int white = 0xffffffff;
+	m_WhiteTexture.reset(new Texture2D(1, 1, &white));
+	m_WhiteTexture->setSampler(SamplerState::nearest());
+	m_TextureSlots[0] = m_WhiteTexture.get();
+}
+
+// out of line for the unique_ptr<Texture2D>
+BatchRenderer::~BatchRenderer()
+{
+}
+
+void BatchRenderer::begin(const float* viewProjection)
+{
+	m_Stats = BatchStats();
+	m_QuadCount = 0;
+	m_TextureSlotCount = 1;
+
+	int samplers[MaxTextureSlots];
+	for (unsigned int i = 0; i < MaxTextureSlots; i++)
+		samplers[i] = (int)i;
+	m_Shader.bind();
+	m_Shader.setUniformMat4f("u_ViewProjection", viewProjection ? viewProjection : s_IdentityMatrix);
+	m_Shader.setUniform1iv("u_Textures", samplers, MaxTextureSlots);
+}
+
+void BatchRenderer::drawQuad(float x, float y, float width, float height, const float color[4])
+{
+	if (m_QuadCount == m_MaxQuads)
+		flush();
+	pushQuad(x, y, width, height, s_FullTexture, packColor(color), 0.0f);
+}
+
+void BatchRenderer::drawQuad(float x, float y, float width, float height, const Texture2D* texture, const float* uv, const float* color)
+{
+	if (m_QuadCount == m_MaxQuads)
+		flush();
+	// after the capacity check: a flush there would reset the slots
+	float slot = getTextureSlot(texture);
+	pushQuad(x, y, width, height, uv ? uv : s_FullTexture, color ? packColor(color) : 0xffffffff, slot);
+}
+
+void BatchRenderer::end()
+{
+	flush();
+}
+
+void BatchRenderer::flush()
+{
+	if (m_QuadCount == 0)
+		return;
+	PROFILE_SCOPE("BatchRenderer::flush");
+
+	// the previous batch may still be drawing from the buffer
+	m_VertexBuffer->orphan();
+	m_VertexBuffer->setData(m_Vertices.data(), m_QuadCount * 4 * (unsigned int)sizeof(BatchVertex));
+
+	// slots keep their texture from one batch to the next more often than not
+	for (unsigned int i = 0; i < m_TextureSlotCount; i++)
+		m_TextureSlots[i]->bind(i);
+
+	m_Shader.bind();
+	m_Renderer.draw(*m_VertexArray, *m_IndexBuffer, m_QuadCount * 6);
+
+	m_Stats.quads += m_QuadCount;
+	m_Stats.flushes++;
+	m_QuadCount = 0;
+	m_TextureSlotCount = 1;
+}
+
+unsigned int BatchRenderer::packColor(const float color[4])
+{
+	unsigned int packed = 0;
+	for (int i = 0; i < 4; i++) {
+		float c = color[i] < 0.0f ? 0.0f : color[i] > 1.0f ? 1.0f : color[i];
+		packed |= (unsigned int)(c * 255.0f + 0.5f) << (i * 8);	// r in the lowest byte, i.e. first in memory
+	}
+	return packed;
+}
+
+void BatchRenderer::ortho(float left, float right, float bottom, float top, float out[16])
+{
+	for (int i = 0; i < 16; i++)
+		out[i] = 0.0f;
+	out[0] = 2.0f / (right - left);
+	out[5] = 2.0f / (top - bottom);
+	out[10] = -1.0f;
+	out[12] = -(right + left) / (right - left);
+	out[13] = -(top + bottom) / (top - bottom);
+	out[15] = 1.0f;
+}
+
+void BatchRenderer::pushQuad(float x, float y, float width, float height, const float* uv, unsigned int color, float slot)
+{
+	// written out, this runs for every quad of every frame
+	float right = x + width, top = y + height;
+	BatchVertex* vertex = &m_Vertices[m_QuadCount * 4];
+	vertex[0] = { { x, y }, { uv[0], uv[1] }, color, slot };
+	vertex[1] = { { right, y }, { uv[2], uv[1] }, color, slot };
+	vertex[2] = { { right, top }, { uv[2], uv[3] }, color, slot };
+	vertex[3] = { { x, top }, { uv[0], uv[3] }, color, slot };
+	m_QuadCount++;
+}
+
+float BatchRenderer::getTextureSlot(const Texture2D* texture)
+{
+	if (!texture)
+		return 0.0f;
+	for (unsigned int i = 0; i < m_TextureSlotCount; i++)
+		if (m_TextureSlots[i] == texture)
+			return (float)i;
+
+	if (m_TextureSlotCount == MaxTextureSlots)
+		flush();
+	m_TextureSlots[m_TextureSlotCount] = texture;
+	return (float)m_TextureSlotCount++;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+
+class Renderer;
+class Shader;
+class Texture2D;
+
+// 24 bytes, the layout res/shaders/batch.shader reads
+struct BatchVertex {
+	float position[2];
+	float texCoord[2];
+	unsigned int color;		// RGBA8, see BatchRenderer::packColor
+	float texSlot;			// index into u_Textures
+};
+
+// What the last begin() / end() pair submitted.
+struct BatchStats {
+	unsigned int quads;
+	unsigned int flushes;	// = draw calls
+};
+
+// Collects quads into a CPU vertex array and draws them with one glDrawElements per
+// batch. The index buffer is built once for the whole capacity (every quad uses the same
+// 0, 1, 2, 2, 3, 0 pattern), so a flush only uploads vertices. A batch is flushed when
+// it holds maxQuads quads, when a quad needs a texture and all slots are taken, and at end().
+//
+// Slot 0 is a 1x1 white texture, so solid and textured quads share batches; a null texture
+// means white. Textures aren't part of FrameCapture captures yet.
+class BatchRenderer
+{
+public:
+	static const unsigned int DefaultMaxQuads = 10000;
+	static const unsigned int MaxTextureSlots = 16;		// GL 3.3 guarantees 16 fragment units
+
+private:
+	const Renderer& m_Renderer;
+	Shader& m_Shader;
+	unsigned int m_MaxQuads;
+
+	std::unique_ptr<VertexArray> m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	std::vector<BatchVertex> m_Vertices;		// m_MaxQuads * 4, allocated once
+	unsigned int m_QuadCount;
+
+	const Texture2D* m_TextureSlots[MaxTextureSlots];
+	unsigned int m_TextureSlotCount;
+	std::unique_ptr<Texture2D> m_WhiteTexture;
+
+	BatchStats m_Stats;
+
+public:
+	// shader: res/shaders/batch.shader or a compatible program
+	BatchRenderer(const Renderer& renderer, Shader& shader, unsigned int maxQuads = DefaultMaxQuads);
+	~BatchRenderer();
+
+	// viewProjection: column-major 4x4, nullptr = positions are in clip space already
+	void begin(const float* viewProjection = nullptr);
+	// solid quad, (x, y) is the lower left corner
+	void drawQuad(float x, float y, float width, float height, const float color[4]);
+	// textured quad; uv = u0, v0, u1, v1 (nullptr = the whole texture), color tints (nullptr = white)
+	void drawQuad(float x, float y, float width, float height, const Texture2D* texture, const float* uv = nullptr, const float* color = nullptr);
+	// draws what's left
+	void end();
+	// draws the current batch and starts a new one
+	void flush();
+
+	inline const BatchStats& getStats() const { return m_Stats; }
+	inline unsigned int getMaxQuads() const { return m_MaxQuads; }
+
+	static unsigned int packColor(const float color[4]);
+	// column-major orthographic projection for begin(), near / far = -1 / 1
+	static void ortho(float left, float right, float bottom, float top, float out[16]);
+
+private:
+	void pushQuad(float x, float y, float width, float height, const float* uv, unsigned int color, float slot);
+	// slot of texture in the current batch, flushes when all slots are taken
+	float getTextureSlot(const Texture2D* texture);
+};
@@ -0,0 +1,151 @@
+#include "BlockDecoder.h"
+#include "Profiler.h"
+
+namespace {
+
+	// one decoded block, 16 texels row by row
+	typedef unsigned char Block[16][4];
+
+	void expand565(unsigned int color, unsigned char* rgb)
+	{
+		unsigned int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+		rgb[0] = (unsigned char)(r << 3 | r >> 2);
+		rgb[1] = (unsigned char)(g << 2 | g >> 4);
+		rgb[2] = (unsigned char)(b << 3 | b >> 2);
+	}
+
+	// BC1 color block; fourColors forces the 4 color mode (BC2 / BC3 color blocks)
+	void decodeColor(const unsigned char* p, bool fourColors, bool alpha, Block& out)
+	{
+		unsigned int c0 = p[0] | p[1] << 8, c1 = p[2] | p[3] << 8;
+		unsigned char palette[4][4];
+		expand565(c0, palette[0]);
+		expand565(c1, palette[1]);
+		for (int i = 0; i < 3; i++) {
+			if (fourColors || c0 > c1) {
+				palette[2][i] = (unsigned char)((2 * palette[0][i] + palette[1][i] + 1) / 3);
+				palette[3][i] = (unsigned char)((palette[0][i] + 2 * palette[1][i] + 1) / 3);
+			}
+			else {
+				palette[2][i] = (unsigned char)((palette[0][i] + palette[1][i] + 1) / 2);
+				palette[3][i] = 0;
+			}
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		if (!fourColors && c0 <= c1 && alpha)
+			palette[3][3] = 0;
+
+		unsigned int indices = p[4] | p[5] << 8 | p[6] << 16 | (unsigned int)p[7] << 24;
+		for (int i = 0; i < 16; i++) {
+			const unsigned char* color = palette[(indices >> (2 * i)) & 3];
+			out[i][0] = color[0];
+			out[i][1] = color[1];
+			out[i][2] = color[2];
+			out[i][3] = color[3];
+		}
+	}
+
+	// BC4 block (also the BC3 alpha and both BC5 channels) into channel c
+	void decodeChannel(const unsigned char* p, int c, Block& out)
+	{
+		unsigned int a0 = p[0], a1 = p[1];
+		unsigned char values[8] = { (unsigned char)a0, (unsigned char)a1 };
+		if (a0 > a1) {
+			for (unsigned int i = 1; i < 7; i++)
+				values[i + 1] = (unsigned char)(((7 - i) * a0 + i * a1 + 3) / 7);
+		}
+		else {
+			for (unsigned int i = 1; i < 5; i++)
+				values[i + 1] = (unsigned char)(((5 - i) * a0 + i * a1 + 2) / 5);
+			values[6] = 0;
+			values[7] = 255;
+		}
+		unsigned long long indices = 0;
+		for (int i = 0; i < 6; i++)
+			indices |= (unsigned long long)p[2 + i] << (8 * i);
+		for (int i = 0; i < 16; i++)
+			out[i][c] = values[(indices >> (3 * i)) & 7];
+	}
+
+	void decodeBlock(TextureFormat format, const unsigned char* p, Block& out)
+	{
+		switch (format) {
+			case TextureFormat::BC1:
+				decodeColor(p, false, false, out);
+				break;
+			case TextureFormat::BC1_Alpha:
+				decodeColor(p, false, true, out);
+				break;
+			case TextureFormat::BC2:
+				decodeColor(p + 8, true, false, out);
+				for (int i = 0; i < 16; i++) {
+					unsigned int a = (p[i / 2] >> (4 * (i & 1))) & 15;
+					out[i][3] = (unsigned char)(a << 4 | a);
+				}
+				break;
+			case TextureFormat::BC3:
+				decodeColor(p + 8, true, false, out);
+				decodeChannel(p, 3, out);
+				break;
+			case TextureFormat::BC4:
+				decodeChannel(p, 0, out);
+				for (int i = 0; i < 16; i++) {
+					out[i][1] = out[i][2] = 0;
+					out[i][3] = 255;
+				}
+				break;
+			case TextureFormat::BC5:
+				decodeChannel(p, 0, out);
+				decodeChannel(p + 8, 1, out);
+				for (int i = 0; i < 16; i++) {
+					out[i][2] = 0;
+					out[i][3] = 255;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+}
+
+bool BlockDecoder::canDecode(TextureFormat format)
+{
+	switch (format) {
+		case TextureFormat::BC1:
+		case TextureFormat::BC1_Alpha:
+		case TextureFormat::BC2:
+		case TextureFormat::BC3:
+		case TextureFormat::BC4:
+		case TextureFormat::BC5:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool BlockDecoder::decode(TextureFormat format, const unsigned char* blocks, size_t size, unsigned int width, unsigned int height, unsigned char* rgba)
+{
+	PROFILE_SCOPE("BlockDecoder::decode");
+	if (!canDecode(format) || size < Texture::getImageSize(format, width, height))
+		return false;
+	unsigned int blockBytes = Texture::getImageSize(format, 4, 4);
+	unsigned int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	Block block;
+	for (unsigned int by = 0; by < blocksY; by++) {
+		for (unsigned int bx = 0; bx < blocksX; bx++) {
+			decodeBlock(format, blocks + ((size_t)by * blocksX + bx) * blockBytes, block);
+			// the last block row / column may hang over the image
+			for (unsigned int y = 0; y < 4 && by * 4 + y < height; y++) {
+				unsigned char* row = rgba + ((size_t)(by * 4 + y) * width + bx * 4) * 4;
+				for (unsigned int x = 0; x < 4 && bx * 4 + x < width; x++) {
+					row[x * 4 + 0] = block[y * 4 + x][0];
+					row[x * 4 + 1] = block[y * 4 + x][1];
+					row[x * 4 + 2] = block[y * 4 + x][2];
+					row[x * 4 + 3] = block[y * 4 + x][3];
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Texture.h"
+#include <cstddef>
+
+// Software decode of the S3TC / RGTC block formats (BC1 - BC5) to RGBA8, for drivers that
+// can't sample them. Blocks are decoded in storage order, block row 0 becomes the first
+// output row, so the result has the same orientation as the compressed upload would.
+// BC4 decodes to (r, 0, 0, 255) and BC5 to (r, g, 0, 255), like GL samples them.
+class BlockDecoder
+{
+public:
+	static bool canDecode(TextureFormat format);
+	// blocks: getImageSize(format, width, height) bytes; rgba: width * height * 4 bytes
+	static bool decode(TextureFormat format, const unsigned char* blocks, size_t size, unsigned int width, unsigned int height, unsigned char* rgba);
+};
@@ -0,0 +1,456 @@
+#include "FrameCapture.h"
+#include "Renderer.h"
+#include "Log.h"
+#include "VertexBufferLayout.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+	struct BufferInfo {
+		unsigned int target;
+		unsigned int size;
+	};
+
+	struct Binding {
+		unsigned int buffer;
+		unsigned int firstAttribute;
+		unsigned int stride;
+		unsigned int divisor;
+		std::vector<VertexBufferElement> elements;
+	};
+
+	struct ProgramInfo {
+		std::string vertexSource;
+		std::string fragmentSource;
+	};
+
+	// every live wrapper resource, keyed by GL name, so a capture can start at any frame
+	std::unordered_map<unsigned int, BufferInfo> s_Buffers;
+	std::unordered_map<unsigned int, std::vector<Binding>> s_VertexArrays;
+	std::unordered_map<unsigned int, ProgramInfo> s_Programs;
+
+	std::string s_FilePath;
+	unsigned int s_Frames = 0;
+	unsigned int s_FramesLeft = 0;
+	std::vector<unsigned char> s_Stream;
+
+	void put(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		s_Stream.insert(s_Stream.end(), bytes, bytes + size);
+	}
+
+	inline void putCommand(FrameCapture::Command command) { s_Stream.push_back(command); }
+	inline void putUInt(unsigned int value) { put(&value, sizeof(value)); }
+	inline void putFloat(float value) { put(&value, sizeof(value)); }
+
+	void putString(const std::string& text)
+	{
+		putUInt((unsigned int)text.size());
+		put(text.data(), text.size());
+	}
+
+	void putAddBuffer(unsigned int vertexArray, const Binding& binding)
+	{
+		putCommand(FrameCapture::AddBuffer);
+		putUInt(vertexArray);
+		putUInt(binding.buffer);
+		putUInt(binding.firstAttribute);
+		putUInt(binding.stride);
+		putUInt(binding.divisor);
+		putUInt((unsigned int)binding.elements.size());
+		for (const VertexBufferElement& element : binding.elements) {
+			putUInt(element.type);
+			putUInt(element.count);
+			s_Stream.push_back(element.normalized);
+		}
+	}
+
+	// components of a uniform type and whether they're floats; 0 = not something we capture
+	unsigned int getUniformComponents(GLenum type, bool& isFloat)
+	{
+		isFloat = true;
+		switch (type) {
+			case GL_FLOAT:				return 1;
+			case GL_FLOAT_VEC2:			return 2;
+			case GL_FLOAT_VEC3:			return 3;
+			case GL_FLOAT_VEC4:			return 4;
+			case GL_FLOAT_MAT2:			return 4;
+			case GL_FLOAT_MAT3:			return 9;
+			case GL_FLOAT_MAT4:			return 16;
+		}
+		isFloat = false;
+		switch (type) {
+			case GL_INT:
+			case GL_BOOL:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_CUBE:		return 1;
+			case GL_INT_VEC2:			return 2;
+			case GL_INT_VEC3:			return 3;
+			case GL_INT_VEC4:			return 4;
+		}
+		return 0;
+	}
+
+	void putUniforms(unsigned int program)
+	{
+		GLint count = 0;
+		GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count));
+		for (GLint i = 0; i < count; i++) {
+			char name[256];
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			GLCall(glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name));
+
+			bool isFloat;
+			unsigned int components = getUniformComponents(type, isFloat);
+			if (components == 0 || strncmp(name, "gl_", 3) == 0)
+				continue;
+
+			// arrays are reported as "name[0]", every element has its own location
+			std::string base(name, length);
+			if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+				base.resize(base.size() - 3);
+
+			for (GLint element = 0; element < size; element++) {
+				std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+				GLCall(GLint location = glGetUniformLocation(program, elementName.c_str()));
+				if (location < 0)
+					continue;
+
+				unsigned int values[16];
+				if (isFloat) {
+					GLCall(glGetUniformfv(program, location, (GLfloat*)values));
+				}
+				else {
+					GLCall(glGetUniformiv(program, location, (GLint*)values));
+				}
+				putCommand(FrameCapture::Uniform);
+				putString(elementName);
+				putUInt(type);
+				putUInt(components);
+				put(values, components * 4);
+			}
+		}
+	}
+
+	template<typename T>
+	std::vector<unsigned int> sortedKeys(const std::unordered_map<unsigned int, T>& map)
+	{
+		std::vector<unsigned int> keys;
+		for (const auto& entry : map)
+			keys.push_back(entry.first);
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+
+}
+
+bool FrameCapture::s_Enabled = false;
+bool FrameCapture::s_Capturing = false;
+
+void FrameCapture::enable()
+{
+	s_Enabled = true;
+}
+
+bool FrameCapture::begin(const std::string& filepath, unsigned int frames)
+{
+	if (!s_Enabled) {
+		LOG_ERROR("Frame capture isn't enabled, call FrameCapture::enable() before creating resources");
+		return false;
+	}
+	if (s_Capturing) {
+		LOG_WARN("A frame capture is already running");
+		return false;
+	}
+
+	s_FilePath = filepath;
+	s_Frames = s_FramesLeft = frames > 0 ? frames : 1;
+	s_Stream.clear();
+	snapshot();
+	s_Capturing = true;
+	return true;
+}
+
+void FrameCapture::snapshot()
+{
+	GLint viewport[4];
+	GLfloat clearColor[4];
+	GLint program = 0, vertexArray = 0, arrayBuffer = 0;
+	GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+	GLCall(glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor));
+	GLCall(glGetIntegerv(GL_CURRENT_PROGRAM, &program));
+	GLCall(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray));
+	GLCall(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer));
+
+	putCommand(Viewport);
+	for (int i = 0; i < 4; i++)
+		putUInt(viewport[i]);
+	putCommand(ClearColor);
+	for (int i = 0; i < 4; i++)
+		putFloat(clearColor[i]);
+
+	// buffer contents straight from GL; the copy-read target leaves every other binding alone
+	std::vector<unsigned char> contents;
+	for (unsigned int id : sortedKeys(s_Buffers)) {
+		const BufferInfo& buffer = s_Buffers[id];
+		contents.resize(buffer.size);
+		GLCall(glBindBuffer(GL_COPY_READ_BUFFER, id));
+		if (buffer.size > 0) {
+			GLCall(glGetBufferSubData(GL_COPY_READ_BUFFER, 0, buffer.size, contents.data()));
+		}
+
+		putCommand(CreateBuffer);
+		putUInt(id);
+		putUInt(buffer.target);
+		putUInt(buffer.size);
+		s_Stream.push_back(1);
+		put(contents.data(), buffer.size);
+	}
+	GLCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+
+	for (unsigned int id : sortedKeys(s_VertexArrays)) {
+		putCommand(CreateVertexArray);
+		putUInt(id);
+		for (const Binding& binding : s_VertexArrays[id])
+			putAddBuffer(id, binding);
+
+		// the element buffer is vertex array state too
+		GLint elementBuffer = 0;
+		GLCall(glBindVertexArray(id));
+		GLCall(glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer));
+		if (elementBuffer) {
+			putCommand(BindVertexArray);
+			putUInt(id);
+			putCommand(BindBuffer);
+			putUInt(GL_ELEMENT_ARRAY_BUFFER);
+			putUInt(elementBuffer);
+		}
+	}
+	GLCall(glBindVertexArray(vertexArray));
+
+	for (unsigned int id : sortedKeys(s_Programs)) {
+		const ProgramInfo& info = s_Programs[id];
+		putCommand(CreateProgram);
+		putUInt(id);
+		putString(info.vertexSource);
+		putString(info.fragmentSource);
+		putCommand(UseProgram);
+		putUInt(id);
+		putUniforms(id);
+	}
+
+	putCommand(UseProgram);
+	putUInt(program);
+	putCommand(BindVertexArray);
+	putUInt(vertexArray);
+	putCommand(BindBuffer);
+	putUInt(GL_ARRAY_BUFFER);
+	putUInt(arrayBuffer);
+	putCommand(EndSetup);
+}
+
+void FrameCapture::endFrame()
+{
+	if (!s_Capturing)
+		return;
+
+	putCommand(EndFrame);
+	if (--s_FramesLeft > 0)
+		return;
+
+	s_Capturing = false;
+	if (write())
+		LOG_INFO("Captured %u frame(s) to %s (%zu bytes)", s_Frames, s_FilePath.c_str(), s_Stream.size());
+	s_Stream.clear();
+	s_Stream.shrink_to_fit();
+}
+
+bool FrameCapture::write()
+{
+	FILE* file = fopen(s_FilePath.c_str(), "wb");
+	if (!file) {
+		LOG_ERROR("Failed to open '%s' for the frame capture", s_FilePath.c_str());
+		return false;
+	}
+
+	// header: magic, version, frame count, command stream size
+	unsigned int version = FileVersion;
+	unsigned long long size = s_Stream.size();
+	fwrite("GLCAPTR", 1, 8, file);
+	fwrite(&version, sizeof(version), 1, file);
+	fwrite(&s_Frames, sizeof(s_Frames), 1, file);
+	fwrite(&size, sizeof(size), 1, file);
+	fwrite(s_Stream.data(), 1, s_Stream.size(), file);
+
+	bool ok = !ferror(file);
+	fclose(file);
+	if (!ok)
+		LOG_ERROR("Failed to write the frame capture to '%s'", s_FilePath.c_str());
+	return ok;
+}
+
+void FrameCapture::onCreateBuffer(unsigned int id, unsigned int target, const void* data, unsigned int size)
+{
+	if (!s_Enabled)
+		return;
+	s_Buffers[id] = { target, size };
+	if (!s_Capturing)
+		return;
+
+	putCommand(CreateBuffer);
+	putUInt(id);
+	putUInt(target);
+	putUInt(size);
+	s_Stream.push_back(data ? 1 : 0);
+	if (data)
+		put(data, size);
+}
+
+void FrameCapture::onDeleteBuffer(unsigned int id)
+{
+	if (!s_Enabled)
+		return;
+	s_Buffers.erase(id);
+	if (s_Capturing) {
+		putCommand(DeleteBuffer);
+		putUInt(id);
+	}
+}
+
+void FrameCapture::onCreateVertexArray(unsigned int id)
+{
+	if (!s_Enabled)
+		return;
+	s_VertexArrays[id].clear();
+	if (s_Capturing) {
+		putCommand(CreateVertexArray);
+		putUInt(id);
+	}
+}
+
+void FrameCapture::onDeleteVertexArray(unsigned int id)
+{
+	if (!s_Enabled)
+		return;
+	s_VertexArrays.erase(id);
+	if (s_Capturing) {
+		putCommand(DeleteVertexArray);
+		putUInt(id);
+	}
+}
+
+void FrameCapture::onAddBuffer(unsigned int vertexArray, unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstAttribute)
+{
+	if (!s_Enabled)
+		return;
+	// re-adding at the same attribute replaces the binding; assigning keeps the vectors' storage
+	std::vector<Binding>& bindings = s_VertexArrays[vertexArray];
+	Binding* binding = nullptr;
+	for (Binding& existing : bindings)
+		if (existing.firstAttribute == firstAttribute)
+			binding = &existing;
+	if (!binding) {
+		bindings.push_back(Binding());
+		binding = &bindings.back();
+	}
+	binding->buffer = buffer;
+	binding->firstAttribute = firstAttribute;
+	binding->stride = layout.getStride();
+	binding->divisor = layout.getDivisor();
+	binding->elements = layout.getElements();
+
+	if (s_Capturing)
+		putAddBuffer(vertexArray, *binding);
+}
+
+void FrameCapture::onCreateProgram(unsigned int id, const std::string& vertexSource, const std::string& fragmentSource)
+{
+	if (!s_Enabled)
+		return;
+	s_Programs[id] = { vertexSource, fragmentSource };
+	if (s_Capturing) {
+		putCommand(CreateProgram);
+		putUInt(id);
+		putString(vertexSource);
+		putString(fragmentSource);
+	}
+}
+
+void FrameCapture::onDeleteProgram(unsigned int id)
+{
+	if (!s_Enabled)
+		return;
+	s_Programs.erase(id);
+	if (s_Capturing) {
+		putCommand(DeleteProgram);
+		putUInt(id);
+	}
+}
+
+void FrameCapture::onBufferSubData(unsigned int id, unsigned int offset, const void* data, unsigned int size)
+{
+	putCommand(BufferSubData);
+	putUInt(id);
+	putUInt(offset);
+	putUInt(size);
+	put(data, size);
+}
+
+void FrameCapture::onBindBuffer(unsigned int target, unsigned int id)
+{
+	putCommand(BindBuffer);
+	putUInt(target);
+	putUInt(id);
+}
+
+void FrameCapture::onBindVertexArray(unsigned int id)
+{
+	putCommand(BindVertexArray);
+	putUInt(id);
+}
+
+void FrameCapture::onUseProgram(unsigned int id)
+{
+	putCommand(UseProgram);
+	putUInt(id);
+}
+
+void FrameCapture::onUniform(const std::string& name, unsigned int type, const void* values, unsigned int count)
+{
+	putCommand(Uniform);
+	putString(name);
+	putUInt(type);
+	putUInt(count);
+	put(values, count * 4);
+}
+
+void FrameCapture::onClear(unsigned int mask)
+{
+	putCommand(Clear);
+	putUInt(mask);
+}
+
+void FrameCapture::onDrawElements(unsigned int mode, unsigned int count, unsigned int type, unsigned int offset)
+{
+	putCommand(DrawElements);
+	putUInt(mode);
+	putUInt(count);
+	putUInt(type);
+	putUInt(offset);
+}
+
+void FrameCapture::onDrawArraysInstanced(unsigned int mode, unsigned int first, unsigned int count, unsigned int instances)
+{
+	putCommand(DrawArraysInstanced);
+	putUInt(mode);
+	putUInt(first);
+	putUInt(count);
+	putUInt(instances);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class VertexBufferLayout;
+
+// Records what the wrappers do during N frames into a capture file that
+// tools/CaptureReplay.cpp re-issues headless, without the application or its assets.
+//
+// Once enable() has been called the wrappers' reports of every resource they create or
+// delete are kept, so begin() can snapshot all live buffers (read back from GL), vertex
+// array layouts, shader sources and uniform values; until then each report is one branch. After that, binds, uploads, uniform updates, clears and draws are appended
+// as commands until Renderer::endFrame() has closed the requested number of frames.
+// Raw GL calls made outside the wrappers aren't part of the capture.
+class FrameCapture
+{
+public:
+	static const unsigned int FileVersion = 1;
+
+	enum Command : unsigned char {
+		EndSetup = 1,		// snapshot done, frame commands follow
+		EndFrame,
+		CreateBuffer,		// id, target, size, hasData, [bytes]
+		DeleteBuffer,		// id
+		BufferSubData,		// id, offset, size, bytes
+		BindBuffer,			// target, id
+		CreateVertexArray,	// id
+		DeleteVertexArray,	// id
+		AddBuffer,			// vertex array, buffer, first attribute, stride, divisor, n, n x (type, count, normalized)
+		BindVertexArray,	// id
+		CreateProgram,		// id, vertex source, fragment source
+		DeleteProgram,		// id
+		UseProgram,			// id
+		Uniform,			// name, GL type, n, n x float or int depending on the type
+		ClearColor,			// 4 x float
+		Viewport,			// x, y, width, height
+		Clear,				// mask
+		DrawElements,		// mode, count, type, offset
+		DrawArraysInstanced	// mode, first, count, instances
+	};
+
+	// starts keeping track of live resources, call it before the first one is created
+	static void enable();
+	static inline bool isEnabled() { return s_Enabled; }
+	// starts capturing `frames` frames, call it at the start of a frame. The file is written
+	// once the last frame ends; false if not enabled or a capture is already running
+	static bool begin(const std::string& filepath, unsigned int frames = 1);
+	static inline bool isCapturing() { return s_Capturing; }
+	// called by Renderer::endFrame
+	static void endFrame();
+
+	// resource lifetime, always called by the wrappers; ignored until enable()
+	static void onCreateBuffer(unsigned int id, unsigned int target, const void* data, unsigned int size);
+	static void onDeleteBuffer(unsigned int id);
+	static void onCreateVertexArray(unsigned int id);
+	static void onDeleteVertexArray(unsigned int id);
+	static void onAddBuffer(unsigned int vertexArray, unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstAttribute);
+	static void onCreateProgram(unsigned int id, const std::string& vertexSource, const std::string& fragmentSource);
+	static void onDeleteProgram(unsigned int id);
+
+	// commands, the wrappers call these only while isCapturing()
+	static void onBufferSubData(unsigned int id, unsigned int offset, const void* data, unsigned int size);
+	static void onBindBuffer(unsigned int target, unsigned int id);
+	static void onBindVertexArray(unsigned int id);
+	static void onUseProgram(unsigned int id);
+	// values are floats or ints to match the GL type, count is in components
+	static void onUniform(const std::string& name, unsigned int type, const void* values, unsigned int count);
+	static void onClear(unsigned int mask);
+	static void onDrawElements(unsigned int mode, unsigned int count, unsigned int type, unsigned int offset);
+	static void onDrawArraysInstanced(unsigned int mode, unsigned int first, unsigned int count, unsigned int instances);
+
+private:
+	static bool s_Enabled;
+	static bool s_Capturing;
+
+	static void snapshot();
+	static bool write();
+};
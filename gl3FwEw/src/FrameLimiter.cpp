@@ -0,0 +1,101 @@
+#include "FrameLimiter.h"
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+// keep the estimate responsive: after this many samples we stop growing the count
+// so a change in scheduler behaviour (power plan, load) is picked up again
+static const long long s_MaxSleepSamples = 1000;
+
+FrameLimiter::FrameLimiter(double targetFps)
+	: m_FrameTime(0.0), m_Started(false),
+	  m_SleepMean(0.002), m_SleepVariance(0.0), m_SleepCount(1), m_SleepEstimate(0.002)
+{
+	setTargetFps(targetFps);
+}
+
+FrameLimiter::~FrameLimiter()
+{
+	setTargetFps(0.0);
+}
+
+void FrameLimiter::setTargetFps(double targetFps)
+{
+	double frameTime = targetFps > 0.0 ? 1.0 / targetFps : 0.0;
+
+#ifdef _WIN32
+	// the default 15.6 ms timer tick makes sleep useless for pacing, ask for 1 ms while we cap
+	if (m_FrameTime <= 0.0 && frameTime > 0.0)
+		timeBeginPeriod(1);
+	else if (m_FrameTime > 0.0 && frameTime <= 0.0)
+		timeEndPeriod(1);
+#endif
+
+	m_FrameTime = frameTime;
+	reset();
+}
+
+void FrameLimiter::reset()
+{
+	m_Started = false;
+}
+
+void FrameLimiter::wait()
+{
+	if (m_FrameTime <= 0.0)
+		return;
+
+	Clock::time_point now = Clock::now();
+	if (!m_Started) {
+		m_Deadline = now;
+		m_Started = true;
+	}
+
+	const Clock::duration frame = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_FrameTime));
+
+	// advance from the previous deadline rather than from "now" so the cap doesn't drift,
+	// but if we fell a whole frame behind, don't try to catch up with a burst of short frames
+	m_Deadline += frame;
+	if (now > m_Deadline + frame) {
+		m_Deadline = now;
+		return;
+	}
+
+	sleepUntil(m_Deadline);
+}
+
+void FrameLimiter::sleepUntil(Clock::time_point deadline)
+{
+	Clock::time_point now = Clock::now();
+
+	// sleep phase: only sleep while even a pessimistic sleep still wakes us before the deadline
+	while (std::chrono::duration<double>(deadline - now).count() > m_SleepEstimate) {
+		Clock::time_point start = now;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = Clock::now();
+		updateSleepEstimate(std::chrono::duration<double>(now - start).count());
+	}
+
+	// spin phase: the last stretch is below the scheduler's resolution
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+void FrameLimiter::updateSleepEstimate(double observed)
+{
+	if (m_SleepCount < s_MaxSleepSamples)
+		m_SleepCount++;
+
+	// incremental mean/variance; once the count is capped this becomes an exponential moving average
+	double alpha = 1.0 / m_SleepCount;
+	double delta = observed - m_SleepMean;
+	m_SleepMean += alpha * delta;
+	m_SleepVariance = (1.0 - alpha) * (m_SleepVariance + alpha * delta * delta);
+
+	m_SleepEstimate = m_SleepMean + std::sqrt(m_SleepVariance);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+
+// Software frame cap: waits until the next frame deadline with a hybrid wait.
+// We sleep while the remaining time is larger than what a sleep is expected to
+// overshoot by, then spin for the last stretch so the deadline is hit within a
+// few microseconds without burning a whole core.
+class FrameLimiter
+{
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double m_FrameTime;				// seconds, 0 = no cap
+	Clock::time_point m_Deadline;
+	bool m_Started;
+
+	// running estimate of how long a 1 ms sleep really takes
+	double m_SleepMean;
+	double m_SleepVariance;
+	long long m_SleepCount;
+	double m_SleepEstimate;
+
+	void sleepUntil(Clock::time_point deadline);
+	void updateSleepEstimate(double observed);
+
+public:
+	FrameLimiter(double targetFps = 0.0);
+	~FrameLimiter();
+
+	void setTargetFps(double targetFps);
+	inline double getTargetFps() const { return m_FrameTime > 0.0 ? 1.0 / m_FrameTime : 0.0; }
+
+	// call once per frame, right after presenting
+	void wait();
+	void reset();
+};
@@ -0,0 +1,75 @@
+#include "FramePacer.h"
+#include "Renderer.h"
+#include "Profiler.h"
+#include <chrono>
+
+FramePacer::FramePacer(unsigned int framesInFlight)
+	: m_FramesInFlight(1), m_FrameIndex(0), m_LastWaitTime(0.0)
+{
+	for (unsigned int i = 0; i < MaxFramesInFlight; i++)
+		m_Fences[i] = nullptr;
+	setFramesInFlight(framesInFlight);
+}
+
+FramePacer::~FramePacer()
+{
+	releaseFences();
+}
+
+void FramePacer::setFramesInFlight(unsigned int framesInFlight)
+{
+	if (framesInFlight < 1) framesInFlight = 1;
+	if (framesInFlight > MaxFramesInFlight) framesInFlight = MaxFramesInFlight;
+
+	// the ring layout depends on the count, so start over from an idle GPU
+	if (framesInFlight != m_FramesInFlight && m_FrameIndex > 0) {
+		GLCall(glFinish());
+		releaseFences();
+	}
+	m_FramesInFlight = framesInFlight;
+}
+
+void FramePacer::releaseFences()
+{
+	for (unsigned int i = 0; i < MaxFramesInFlight; i++) {
+		if (m_Fences[i]) {
+			GLCall(glDeleteSync(m_Fences[i]));
+			m_Fences[i] = nullptr;
+		}
+	}
+}
+
+void FramePacer::beginFrame()
+{
+	GLsync& fence = m_Fences[m_FrameIndex % m_FramesInFlight];
+	m_LastWaitTime = 0.0;
+	if (!fence)
+		return;
+
+	PROFILE_SCOPE("FramePacer::wait");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// flush on the first wait so the fence is guaranteed to get to the GPU, then keep waiting
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLCall(GLenum result = glClientWaitSync(fence, flags, 100000000));	// 100 ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = 0;
+	}
+
+	m_LastWaitTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	GLCall(glDeleteSync(fence));
+	fence = nullptr;
+}
+
+void FramePacer::endFrame()
+{
+	GLsync& fence = m_Fences[m_FrameIndex % m_FramesInFlight];
+	if (fence) {
+		GLCall(glDeleteSync(fence));
+	}
+	GLCall(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	m_FrameIndex++;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Bounds how many frames the CPU may queue ahead of the GPU.
+// A fence goes in after each frame's submission; before starting frame N we wait
+// for the fence of frame N - framesInFlight. 1 = lowest latency, 3 = most throughput.
+class FramePacer
+{
+public:
+	static const unsigned int MaxFramesInFlight = 3;
+
+private:
+	GLsync m_Fences[MaxFramesInFlight];
+	unsigned int m_FramesInFlight;
+	unsigned long long m_FrameIndex;
+	double m_LastWaitTime;		// seconds the CPU blocked in the last beginFrame()
+
+	void releaseFences();
+
+public:
+	FramePacer(unsigned int framesInFlight = 2);
+	~FramePacer();
+
+	// 1..MaxFramesInFlight; waits for the GPU to drain before changing
+	void setFramesInFlight(unsigned int framesInFlight);
+	inline unsigned int getFramesInFlight() const { return m_FramesInFlight; }
+
+	void beginFrame();
+	void endFrame();
+
+	inline double getLastWaitTime() const { return m_LastWaitTime; }
+};
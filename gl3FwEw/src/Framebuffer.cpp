@@ -0,0 +1,181 @@
+#include "Framebuffer.h"
+#include "Renderer.h"
+#include "Profiler.h"
+#include "Log.h"
+
+namespace {
+
+	// creating or invalidating binds the framebuffer; this puts back what the caller had
+	class BindingRestore
+	{
+	private:
+		GLint m_DrawFramebuffer;
+		GLint m_ReadFramebuffer;
+		GLint m_Renderbuffer;
+
+	public:
+		BindingRestore()
+		{
+			GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_DrawFramebuffer));
+			GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &m_ReadFramebuffer));
+			GLCall(glGetIntegerv(GL_RENDERBUFFER_BINDING, &m_Renderbuffer));
+		}
+
+		~BindingRestore()
+		{
+			GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_DrawFramebuffer));
+			GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ReadFramebuffer));
+			GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffer));
+		}
+	};
+
+}
+
+FramebufferSpec FramebufferSpec::normalized() const
+{
+	FramebufferSpec spec = *this;
+	if (spec.colorCount > Framebuffer::MaxColorAttachments)
+		spec.colorCount = Framebuffer::MaxColorAttachments;
+	if (spec.samples < 1)
+		spec.samples = 1;
+	if (spec.samples > Framebuffer::getMaxSamples())
+		spec.samples = Framebuffer::getMaxSamples();
+	return spec;
+}
+
+bool FramebufferSpec::operator==(const FramebufferSpec& other) const
+{
+	return width == other.width && height == other.height && colorFormat == other.colorFormat
+		&& colorCount == other.colorCount && depth == other.depth && samples == other.samples;
+}
+
+Framebuffer::Framebuffer(const FramebufferSpec& spec)
+	: m_RendererID(0), m_Spec(spec.normalized()), m_DepthRenderbuffer(0), m_Complete(false)
+{
+	PROFILE_SCOPE("Framebuffer::create");
+	if (spec.samples > m_Spec.samples)
+		LOG_WARN("Framebuffer: %u samples requested, GL_MAX_SAMPLES is %u", spec.samples, m_Spec.samples);
+	bool multisampled = m_Spec.samples > 1;
+	BindingRestore restore;
+
+	GLCall(glGenFramebuffers(1, &m_RendererID));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+
+	GLenum drawBuffers[MaxColorAttachments];
+	for (unsigned int i = 0; i < m_Spec.colorCount; i++) {
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		if (multisampled) {
+			unsigned int renderbuffer;
+			GLCall(glGenRenderbuffers(1, &renderbuffer));
+			GLCall(glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer));
+			GLCall(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_Spec.samples, Texture::getInternalFormat(m_Spec.colorFormat), m_Spec.width, m_Spec.height));
+			GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, drawBuffers[i], GL_RENDERBUFFER, renderbuffer));
+			m_ColorRenderbuffers.push_back(renderbuffer);
+		}
+		else {
+			m_ColorTextures.emplace_back(new Texture2D(m_Spec.width, m_Spec.height, m_Spec.colorFormat, 1));
+			GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[i], GL_TEXTURE_2D, m_ColorTextures.back()->getRendererID(), 0));
+		}
+	}
+	if (m_Spec.colorCount > 0) {
+		GLCall(glDrawBuffers(m_Spec.colorCount, drawBuffers));
+	}
+	else {
+		GLCall(glDrawBuffer(GL_NONE));
+		GLCall(glReadBuffer(GL_NONE));
+	}
+
+	if (m_Spec.depth) {
+		GLCall(glGenRenderbuffers(1, &m_DepthRenderbuffer));
+		GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer));
+		GLCall(glRenderbufferStorageMultisample(GL_RENDERBUFFER, multisampled ? m_Spec.samples : 0, GL_DEPTH24_STENCIL8, m_Spec.width, m_Spec.height));
+		GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthRenderbuffer));
+	}
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	m_Complete = status == GL_FRAMEBUFFER_COMPLETE;
+	if (!m_Complete)
+		LOG_ERROR("Framebuffer %ux%u x%u incomplete (0x%x)", m_Spec.width, m_Spec.height, m_Spec.samples, (unsigned int)status);
+}
+
+Framebuffer::~Framebuffer()
+{
+	GLCall(glDeleteFramebuffers(1, &m_RendererID));
+	if (!m_ColorRenderbuffers.empty()) {
+		GLCall(glDeleteRenderbuffers((GLsizei)m_ColorRenderbuffers.size(), m_ColorRenderbuffers.data()));
+	}
+	if (m_DepthRenderbuffer) {
+		GLCall(glDeleteRenderbuffers(1, &m_DepthRenderbuffer));
+	}
+}
+
+void Framebuffer::bind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glViewport(0, 0, m_Spec.width, m_Spec.height));
+}
+
+void Framebuffer::bindDefault(unsigned int width, unsigned int height)
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GLCall(glViewport(0, 0, width, height));
+}
+
+void Framebuffer::resolve(const Framebuffer* target, bool depth) const
+{
+	PROFILE_SCOPE("Framebuffer::resolve");
+	unsigned int width = target ? target->getWidth() : m_Spec.width;
+	unsigned int height = target ? target->getHeight() : m_Spec.height;
+	GLbitfield mask = (m_Spec.colorCount > 0 ? GL_COLOR_BUFFER_BIT : 0) | (depth && m_Spec.depth ? GL_DEPTH_BUFFER_BIT : 0);
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_RendererID));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target ? target->getRendererID() : 0));
+	if (m_Spec.colorCount > 0) {
+		GLCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+	}
+	// depth only blits with NEAREST; a resolve has to be the same size anyway
+	GLCall(glBlitFramebuffer(0, 0, m_Spec.width, m_Spec.height, 0, 0, width, height, mask, GL_NEAREST));
+}
+
+void Framebuffer::invalidate(bool color, bool depth) const
+{
+	if (!hasInvalidate())
+		return;
+	GLenum attachments[MaxColorAttachments + 1];
+	GLsizei count = 0;
+	for (unsigned int i = 0; color && i < m_Spec.colorCount; i++)
+		attachments[count++] = GL_COLOR_ATTACHMENT0 + i;
+	if (depth && m_Spec.depth)
+		attachments[count++] = GL_DEPTH_STENCIL_ATTACHMENT;
+	if (count == 0)
+		return;
+	BindingRestore restore;
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments));
+}
+
+const Texture2D* Framebuffer::getColorTexture(unsigned int index) const
+{
+	return index < m_ColorTextures.size() ? m_ColorTextures[index].get() : nullptr;
+}
+
+unsigned long long Framebuffer::getByteSize() const
+{
+	unsigned long long texels = (unsigned long long)m_Spec.width * m_Spec.height * m_Spec.samples;
+	return texels * (m_Spec.colorCount * Texture::getBytesPerPixel(m_Spec.colorFormat) + (m_Spec.depth ? 4 : 0));
+}
+
+bool Framebuffer::hasInvalidate()
+{
+	return GLEW_VERSION_4_3 || GLEW_ARB_invalidate_subdata;
+}
+
+unsigned int Framebuffer::getMaxSamples()
+{
+	static GLint s_MaxSamples = 0;
+	if (s_MaxSamples == 0) {
+		GLCall(glGetIntegerv(GL_MAX_SAMPLES, &s_MaxSamples));
+		if (s_MaxSamples < 1)
+			s_MaxSamples = 1;
+	}
+	return (unsigned int)s_MaxSamples;
+}
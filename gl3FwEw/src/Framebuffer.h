@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Texture.h"
+#include <memory>
+#include <vector>
+
+struct FramebufferSpec {
+	unsigned int width;
+	unsigned int height;
+	TextureFormat colorFormat;
+	unsigned int colorCount;	// color attachments, 0 .. MaxColorAttachments, all colorFormat
+	bool depth;					// a Depth24Stencil8 attachment
+	unsigned int samples;		// > 1 = multisampled
+
+	// samples 0 and 1 both become 1, samples and colorCount are clamped to what GL
+	// supports: what a Framebuffer reports
+	FramebufferSpec normalized() const;
+	bool operator==(const FramebufferSpec& other) const;
+	bool operator!=(const FramebufferSpec& other) const { return !(*this == other); }
+};
+
+// A framebuffer object with its attachments. Single sampled color attachments are textures
+// (getColorTexture), so a pass can sample what the one before it rendered; multisampled
+// ones are renderbuffers that only resolve() reads. Depth is always a renderbuffer.
+// Creating one or invalidate() leave the caller's framebuffer bindings as they were.
+class Framebuffer
+{
+public:
+	static const unsigned int MaxColorAttachments = 4;
+
+private:
+	unsigned int m_RendererID;
+	FramebufferSpec m_Spec;
+	std::vector<std::unique_ptr<Texture2D>> m_ColorTextures;
+	std::vector<unsigned int> m_ColorRenderbuffers;
+	unsigned int m_DepthRenderbuffer;
+	bool m_Complete;
+
+public:
+	Framebuffer(const FramebufferSpec& spec);
+	~Framebuffer();
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// false if GL rejected the combination, the reason was logged
+	inline bool isComplete() const { return m_Complete; }
+
+	// binds for drawing and reading and sets the viewport to cover it
+	void bind() const;
+	// window system framebuffer
+	static void bindDefault(unsigned int width, unsigned int height);
+
+	// glBlitFramebuffer of color attachment 0 (and depth) into target, nullptr = the
+	// default framebuffer; a multisampled framebuffer resolves, sizes have to match then
+	void resolve(const Framebuffer* target, bool depth = false) const;
+	// tells the driver the contents aren't needed any more (glInvalidateFramebuffer, GL 4.3 /
+	// ARB_invalidate_subdata), e.g. depth once the pass is done or MSAA color once resolved,
+	// so tilers skip the store; a no-op without it
+	void invalidate(bool color, bool depth) const;
+
+	// nullptr for multisampled framebuffers
+	const Texture2D* getColorTexture(unsigned int index = 0) const;
+	inline unsigned int getRendererID() const { return m_RendererID; }
+	inline const FramebufferSpec& getSpec() const { return m_Spec; }
+	inline unsigned int getWidth() const { return m_Spec.width; }
+	inline unsigned int getHeight() const { return m_Spec.height; }
+	// GPU memory of all attachments, samples included
+	unsigned long long getByteSize() const;
+
+	static bool hasInvalidate();
+	// GL_MAX_SAMPLES, queried once
+	static unsigned int getMaxSamples();
+};
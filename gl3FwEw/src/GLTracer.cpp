@@ -0,0 +1,163 @@
+#include "GLTracer.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+	struct CallSite {
+		const char* call;
+		const char* file;
+		int line;
+	};
+
+	// allocated by the first enable() and never freed, a late record() can't hit freed memory
+	GLTraceRecord* s_Records = nullptr;
+	unsigned int s_Capacity = 0;
+	std::atomic<unsigned long long> s_Head(0);		// records written since the start
+
+	std::mutex s_Mutex;				// guards everything below, none of it is on the hot path
+	std::vector<CallSite> s_Sites;
+	std::string s_DumpOnError;
+	bool s_DumpedOnError = false;
+
+	std::atomic<unsigned short> s_NextThread(1);
+	thread_local unsigned short t_Thread = 0;
+	thread_local unsigned int t_LastSite = 0;	// the call GLLogCall is checking
+
+	inline unsigned short getThread()
+	{
+		if (!t_Thread)
+			t_Thread = s_NextThread.fetch_add(1);
+		return t_Thread;
+	}
+
+	inline void append(unsigned int site, unsigned int error)
+	{
+		unsigned long long index = s_Head.fetch_add(1, std::memory_order_relaxed);
+		GLTraceRecord& record = s_Records[index & (s_Capacity - 1)];
+		record.timestamp = Profiler::now();
+		record.site = site;
+		record.thread = getThread();
+		record.error = (unsigned short)error;
+	}
+
+	void writeString(FILE* file, const char* text)
+	{
+		unsigned int length = (unsigned int)strlen(text);
+		fwrite(&length, sizeof(length), 1, file);
+		fwrite(text, 1, length, file);
+	}
+
+}
+
+std::atomic<bool> GLTracer::s_Enabled(false);
+
+void GLTracer::enable(unsigned int capacity)
+{
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (!s_Records) {
+			s_Capacity = 1;
+			while (s_Capacity < capacity && s_Capacity < (1u << 31))
+				s_Capacity <<= 1;
+			s_Records = new GLTraceRecord[s_Capacity]();
+		}
+	}
+	s_Enabled.store(true, std::memory_order_release);
+}
+
+void GLTracer::disable()
+{
+	s_Enabled.store(false, std::memory_order_relaxed);
+}
+
+unsigned int GLTracer::registerCallSite(const char* call, const char* file, int line)
+{
+	// keep only the file name, the full path is noise in every decoded line
+	const char* name = file;
+	for (const char* c = file; *c; c++)
+		if (*c == '/' || *c == '\\')
+			name = c + 1;
+
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Sites.push_back({ call, name, line });
+	return (unsigned int)s_Sites.size();
+}
+
+void GLTracer::record(unsigned int site)
+{
+	t_LastSite = site;
+	append(site, 0);
+}
+
+void GLTracer::recordError(unsigned int error)
+{
+	if (!isEnabled())
+		return;
+	append(t_LastSite, error);
+
+	// the first error is the interesting one, don't rewrite the file every frame after it
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (s_DumpOnError.empty() || s_DumpedOnError)
+			return;
+		s_DumpedOnError = true;
+		path = s_DumpOnError;
+	}
+	if (dump(path))
+		LOG_INFO("[GLTracer] GL error, trace written to %s", path.c_str());
+}
+
+void GLTracer::setDumpOnError(const std::string& filepath)
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_DumpOnError = filepath;
+	s_DumpedOnError = false;
+}
+
+bool GLTracer::dump(const std::string& filepath)
+{
+	FILE* file = fopen(filepath.c_str(), "wb");
+	if (!file) {
+		LOG_ERROR("Failed to open '%s' for the GL trace", filepath.c_str());
+		return false;
+	}
+
+	std::vector<CallSite> sites;
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		sites = s_Sites;
+	}
+	unsigned long long head = s_Head.load(std::memory_order_acquire);
+	unsigned long long count = head < s_Capacity ? head : s_Capacity;
+
+	// header: magic, version, site count, records in the file, records written in total
+	unsigned int version = FileVersion;
+	unsigned int siteCount = (unsigned int)sites.size();
+	fwrite("GLTRACE", 1, 8, file);
+	fwrite(&version, sizeof(version), 1, file);
+	fwrite(&siteCount, sizeof(siteCount), 1, file);
+	fwrite(&count, sizeof(count), 1, file);
+	fwrite(&head, sizeof(head), 1, file);
+
+	for (const CallSite& site : sites) {
+		fwrite(&site.line, sizeof(site.line), 1, file);
+		writeString(file, site.call);
+		writeString(file, site.file);
+	}
+
+	// the ring wraps, write it out oldest first
+	for (unsigned long long i = head - count; i < head; i++)
+		fwrite(&s_Records[i & (s_Capacity - 1)], sizeof(GLTraceRecord), 1, file);
+
+	bool ok = !ferror(file);
+	fclose(file);
+	if (!ok)
+		LOG_ERROR("Failed to write the GL trace to '%s'", filepath.c_str());
+	return ok;
+}
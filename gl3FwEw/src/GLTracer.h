@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// Compile-time switch: build with GL_TRACING=0 and GLCall does no tracing work at all.
+// With it on, a disabled tracer costs one relaxed load per GLCall.
+#ifndef GL_TRACING
+#define GL_TRACING 1
+#endif
+
+// One traced GL call. 16 bytes, written as is into the ring and the dump file.
+struct GLTraceRecord {
+	unsigned long long timestamp;	// ns, same clock as Profiler::now()
+	unsigned int site;				// call-site ID, index + 1 into the dump's site table
+	unsigned short thread;
+	unsigned short error;			// 0, or the GL error GLLogCall found after the call
+};
+
+// Records every GLCall into a preallocated ring: a call-site ID, the thread and a
+// timestamp, nothing formatted. Call sites register once, the first time they run,
+// with the text GLCall already stringifies. dump() writes the ring plus the site
+// table to a binary file for tools/GLTraceDecode.cpp; so does the first GL error
+// when setDumpOnError() was given a path.
+class GLTracer
+{
+public:
+	static const unsigned int FileVersion = 1;
+
+	// capacity is rounded up to a power of two; allocates on the first enable only
+	static void enable(unsigned int capacity = 1 << 16);
+	static void disable();
+	static inline bool isEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+	static unsigned int registerCallSite(const char* call, const char* file, int line);
+	static void record(unsigned int site);
+	// called by GLLogCall for every error it reports
+	static void recordError(unsigned int error);
+
+	// empty path = don't dump on errors (the default)
+	static void setDumpOnError(const std::string& filepath);
+	// oldest record first; records written by other threads during the dump may be torn
+	static bool dump(const std::string& filepath);
+
+private:
+	static std::atomic<bool> s_Enabled;
+};
+
+#if GL_TRACING
+// the lambda gives every expansion its own static, i.e. one registration per call site
+// takes the already stringified call: an argument stringified one macro deeper would be expanded first
+#define GLTraceCall(call) (GLTracer::isEnabled() ? GLTracer::record([]() {\
+		static const unsigned int site = GLTracer::registerCallSite(call, __FILE__, __LINE__);\
+		return site;\
+	}()) : (void)0)
+#else
+#define GLTraceCall(call) ((void)0)
+#endif
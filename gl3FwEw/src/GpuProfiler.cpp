@@ -0,0 +1,176 @@
+#include "GpuProfiler.h"
+#include "Renderer.h"
+#include "Log.h"
+
+GpuProfiler::GpuProfiler(const char* trackName)
+	: m_Oldest(0), m_PendingCount(0), m_Recording(false), m_Track(Profiler::createTrack(trackName)),
+	m_ClockOffset(0), m_Supported(false), m_LastResolvedFrame(-1), m_DroppedFrames(0)
+{
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) {
+		// a timestamp counter with 0 bits means the implementation can't time at all
+		GLint bits = 0;
+		GLCall(glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits));
+		m_Supported = bits > 0;
+	}
+	if (!m_Supported) {
+		LOG_WARN("GL timer queries aren't supported, GPU scopes won't be timed");
+		return;
+	}
+	calibrate();
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	if (!m_Queries.empty()) {
+		GLCall(glDeleteQueries((GLsizei)m_Queries.size(), m_Queries.data()));
+	}
+}
+
+void GpuProfiler::calibrate()
+{
+	if (!m_Supported)
+		return;
+
+	GLint64 gpuTime = 0;
+	GLCall(glGetInteger64v(GL_TIMESTAMP, &gpuTime));
+	m_ClockOffset = (long long)Profiler::now() - gpuTime;
+}
+
+unsigned int GpuProfiler::acquireQuery()
+{
+	if (m_FreeQueries.empty()) {
+		unsigned int queries[32];
+		GLCall(glGenQueries(32, queries));
+		m_Queries.insert(m_Queries.end(), queries, queries + 32);
+		m_FreeQueries.insert(m_FreeQueries.end(), queries, queries + 32);
+	}
+	unsigned int query = m_FreeQueries.back();
+	m_FreeQueries.pop_back();
+	return query;
+}
+
+void GpuProfiler::recycle(Frame& frame)
+{
+	for (const Scope& scope : frame.scopes) {
+		m_FreeQueries.push_back(scope.beginQuery);
+		if (scope.endQuery)
+			m_FreeQueries.push_back(scope.endQuery);
+	}
+	frame.scopes.clear();
+	frame.lastQuery = 0;
+}
+
+bool GpuProfiler::resolveOldest(bool wait)
+{
+	Frame& frame = m_Frames[m_Oldest];
+	if (frame.lastQuery && !wait) {
+		GLuint available = GL_FALSE;
+		GLCall(glGetQueryObjectuiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available)
+			return false;
+	}
+
+	for (const Scope& scope : frame.scopes) {
+		if (!scope.endQuery)
+			continue;
+
+		GLuint64 begin = 0, end = 0;
+		GLCall(glGetQueryObjectui64v(scope.beginQuery, GL_QUERY_RESULT, &begin));
+		GLCall(glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end));
+
+		long long cpuBegin = (long long)begin + m_ClockOffset;
+		ProfileEvent event;
+		event.name = scope.name;
+		event.begin = cpuBegin > 0 ? (unsigned long long)cpuBegin : 0;
+		event.end = event.begin + (end > begin ? end - begin : 0);
+		event.depth = scope.depth;
+		event.frame = frame.index;
+		Profiler::record(m_Track, event);
+	}
+
+	m_LastResolvedFrame = (long long)frame.index;
+	recycle(frame);
+	m_Oldest = (m_Oldest + 1) % MaxPendingFrames;
+	m_PendingCount--;
+	return true;
+}
+
+void GpuProfiler::beginFrame()
+{
+	if (m_Recording)
+		endFrame();
+	if (!m_Supported)
+		return;
+
+	while (m_PendingCount > 0 && resolveOldest(false));
+
+	if (!Profiler::isEnabled())
+		return;
+
+	// every slot is still waiting on the GPU: drop the oldest rather than stall on it
+	if (m_PendingCount == MaxPendingFrames) {
+		recycle(m_Frames[m_Oldest]);
+		m_Oldest = (m_Oldest + 1) % MaxPendingFrames;
+		m_PendingCount--;
+		m_DroppedFrames++;
+	}
+
+	Frame& frame = m_Frames[(m_Oldest + m_PendingCount) % MaxPendingFrames];
+	frame.index = Profiler::getFrameIndex();
+	frame.scopes.clear();
+	frame.lastQuery = 0;
+	m_OpenScopes.clear();
+	m_Recording = true;
+}
+
+void GpuProfiler::endFrame()
+{
+	if (!m_Recording)
+		return;
+
+	while (!m_OpenScopes.empty())
+		endScope();
+
+	m_PendingCount++;
+	m_Recording = false;
+}
+
+void GpuProfiler::beginScope(const char* name)
+{
+	if (!m_Recording)
+		return;
+
+	Frame& frame = m_Frames[(m_Oldest + m_PendingCount) % MaxPendingFrames];
+	Scope scope;
+	scope.name = name;
+	scope.beginQuery = acquireQuery();
+	scope.endQuery = 0;
+	scope.depth = (unsigned int)m_OpenScopes.size();
+	GLCall(glQueryCounter(scope.beginQuery, GL_TIMESTAMP));
+
+	m_OpenScopes.push_back((unsigned int)frame.scopes.size());
+	frame.scopes.push_back(scope);
+	frame.lastQuery = scope.beginQuery;
+}
+
+void GpuProfiler::endScope()
+{
+	if (!m_Recording || m_OpenScopes.empty())
+		return;
+
+	Frame& frame = m_Frames[(m_Oldest + m_PendingCount) % MaxPendingFrames];
+	Scope& scope = frame.scopes[m_OpenScopes.back()];
+	m_OpenScopes.pop_back();
+
+	scope.endQuery = acquireQuery();
+	GLCall(glQueryCounter(scope.endQuery, GL_TIMESTAMP));
+	frame.lastQuery = scope.endQuery;
+}
+
+void GpuProfiler::flush()
+{
+	if (m_Recording)
+		endFrame();
+	while (m_PendingCount > 0)
+		resolveOldest(true);
+}
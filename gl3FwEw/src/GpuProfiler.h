@@ -0,0 +1,101 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "Profiler.h"
+
+// Times GPU work per scope with GL_TIMESTAMP query pairs (ARB_timer_query, core in 3.3).
+// Timestamps nest, unlike GL_TIME_ELAPSED, so scopes can too. Results are only read
+// once GL_QUERY_RESULT_AVAILABLE says so, usually a few frames later, and then go to
+// the Profiler on their own track, shifted onto the CPU clock. So GPU scopes show up
+// in the same trace and frame report as the CPU ones, under the frame that issued them.
+class GpuProfiler
+{
+public:
+	static const unsigned int MaxPendingFrames = 8;
+
+private:
+	struct Scope {
+		const char* name;
+		unsigned int beginQuery;
+		unsigned int endQuery;
+		unsigned int depth;
+	};
+
+	struct Frame {
+		unsigned long long index;	// Profiler frame index
+		std::vector<Scope> scopes;
+		unsigned int lastQuery;		// queries finish in order, this one being available means all are
+	};
+
+	Frame m_Frames[MaxPendingFrames];
+	unsigned int m_Oldest;			// oldest frame waiting for results
+	unsigned int m_PendingCount;
+	bool m_Recording;				// between beginFrame and endFrame with the profiler enabled
+	std::vector<unsigned int> m_OpenScopes;
+
+	std::vector<unsigned int> m_Queries;		// every query we created
+	std::vector<unsigned int> m_FreeQueries;
+
+	ProfileTrack* m_Track;
+	long long m_ClockOffset;		// CPU ns - GPU ns
+	bool m_Supported;
+	long long m_LastResolvedFrame;
+	unsigned int m_DroppedFrames;
+
+	unsigned int acquireQuery();
+	void recycle(Frame& frame);
+	// true if the oldest pending frame was resolved
+	bool resolveOldest(bool wait);
+
+public:
+	GpuProfiler(const char* trackName = "GPU");
+	~GpuProfiler();
+
+	// resolves every finished frame without blocking, then starts recording a new one.
+	// Call after Profiler::markFrame() so the GPU scopes land in the right frame.
+	void beginFrame();
+	void endFrame();
+
+	// name must be a string literal, like for PROFILE_SCOPE
+	void beginScope(const char* name);
+	void endScope();
+
+	// blocks until every pending frame is resolved, for reports on shutdown
+	void flush();
+	// re-reads the GPU clock; GPU and CPU clocks drift apart over long runs
+	void calibrate();
+
+	inline bool isSupported() const { return m_Supported; }
+	// last frame whose GPU scopes reached the Profiler, -1 if none yet
+	inline long long getLastResolvedFrame() const { return m_LastResolvedFrame; }
+	// frames thrown away because their results took longer than MaxPendingFrames
+	inline unsigned int getDroppedFrameCount() const { return m_DroppedFrames; }
+};
+
+class GpuProfileScope
+{
+private:
+	GpuProfiler& m_Profiler;
+
+public:
+	inline GpuProfileScope(GpuProfiler& profiler, const char* name)
+		: m_Profiler(profiler)
+	{
+		m_Profiler.beginScope(name);
+	}
+
+	inline ~GpuProfileScope()
+	{
+		m_Profiler.endScope();
+	}
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+#if PROFILING
+#define GPU_PROFILE_SCOPE(profiler, name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+#else
+#define GPU_PROFILE_SCOPE(profiler, name)
+#endif
@@ -0,0 +1,174 @@
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "Renderer.h"
+#include "SamplerCache.h"
+#include "TextureUnits.h"
+#include "Log.h"
+#include <EGL/eglext.h>
+#include <cstring>
+
+static bool hasExtension(const char* extensions, const char* name)
+{
+	if (!extensions)
+		return false;
+
+	size_t length = strlen(name);
+	for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+		// make sure we matched a whole word and not a prefix of a longer name
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+HeadlessContext::HeadlessContext(int width, int height)
+	: m_Display(EGL_NO_DISPLAY), m_Context(EGL_NO_CONTEXT), m_Surface(EGL_NO_SURFACE), m_Valid(false),
+	  m_Width(width), m_Height(height)
+{
+	if (!createContext())
+		return;
+
+	// GLEW's GLX half fails without an X display, the GL entry points are loaded before that
+	glewExperimental = GL_TRUE;
+	GLenum result = glewInit();
+	if (result != GLEW_OK && result != GLEW_ERROR_NO_GLX_DISPLAY) {
+		LOG_ERROR("[Headless] glewInit failed: %s", (const char*)glewGetErrorString(result));
+		return;
+	}
+	GLClearError();	// glewInit may leave GL_INVALID_ENUM behind on core profiles
+
+	if (!createFramebuffer())
+		return;
+
+	LOG_INFO("GL_VERSION: %s", (const char*)glGetString(GL_VERSION));
+	LOG_INFO("GL_RENDERER: %s", (const char*)glGetString(GL_RENDERER));
+	m_Valid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_Context != EGL_NO_CONTEXT) {
+		makeCurrent();
+		m_Framebuffer.reset();
+		// the shared samplers and the bind shadow belong to this context
+		SamplerCache::clear();
+		TextureUnits::invalidate();
+		eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_Display, m_Context);
+	}
+	if (m_Surface != EGL_NO_SURFACE)
+		eglDestroySurface(m_Display, m_Surface);
+	if (m_Display != EGL_NO_DISPLAY)
+		eglTerminate(m_Display);
+}
+
+bool HeadlessContext::createContext()
+{
+	// prefer Mesa's surfaceless platform: it needs neither X, Wayland nor a DRM device
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+			m_Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (m_Display == EGL_NO_DISPLAY)
+		m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, &major, &minor)) {
+		LOG_ERROR("[Headless] No EGL display available");
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		LOG_ERROR("[Headless] EGL can't create desktop OpenGL contexts");
+		return false;
+	}
+
+	const char* displayExtensions = eglQueryString(m_Display, EGL_EXTENSIONS);
+	bool surfaceless = hasExtension(displayExtensions, "EGL_KHR_surfaceless_context");
+
+	EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(m_Display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+		LOG_ERROR("[Headless] No suitable EGL config");
+		return false;
+	}
+
+	// same context the window path asks GLFW for: 3.3 core
+	EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (m_Context == EGL_NO_CONTEXT) {
+		LOG_ERROR("[Headless] Failed to create an OpenGL 3.3 core context (0x%x)", (unsigned int)eglGetError());
+		return false;
+	}
+
+	// without surfaceless contexts we still need something to make current
+	if (!surfaceless) {
+		EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		m_Surface = eglCreatePbufferSurface(m_Display, config, pbufferAttribs);
+		if (m_Surface == EGL_NO_SURFACE) {
+			LOG_ERROR("[Headless] Failed to create a pbuffer surface");
+			return false;
+		}
+	}
+
+	if (!eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context)) {
+		LOG_ERROR("[Headless] eglMakeCurrent failed");
+		return false;
+	}
+	return true;
+}
+
+bool HeadlessContext::createFramebuffer()
+{
+	FramebufferSpec spec = { (unsigned int)m_Width, (unsigned int)m_Height, TextureFormat::RGBA8, 1, true, 1 };
+	m_Framebuffer.reset(new Framebuffer(spec));
+	if (!m_Framebuffer->isComplete()) {
+		LOG_ERROR("[Headless] Framebuffer incomplete");
+		return false;
+	}
+
+	bind();
+	return true;
+}
+
+void HeadlessContext::makeCurrent() const
+{
+	eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context);
+}
+
+void HeadlessContext::bind() const
+{
+	m_Framebuffer->bind();
+}
+
+void HeadlessContext::resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	m_Valid = createFramebuffer();
+}
+
+unsigned int HeadlessContext::getFramebuffer() const
+{
+	return m_Framebuffer ? m_Framebuffer->getRendererID() : 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <EGL/egl.h>
+#include <memory>
+
+class Framebuffer;
+
+// An OpenGL 3.3 core context without a window, for display-less render servers.
+// The context comes from EGL (surfaceless platform when Mesa offers it, a 1x1 pbuffer otherwise)
+// and everything is rendered into a framebuffer object of the requested size,
+// so the usual VertexArray/VertexBuffer/IndexBuffer/Shader code runs unchanged.
+class HeadlessContext
+{
+private:
+	EGLDisplay m_Display;
+	EGLContext m_Context;
+	EGLSurface m_Surface;
+	bool m_Valid;
+
+	std::unique_ptr<Framebuffer> m_Framebuffer;
+	int m_Width;
+	int m_Height;
+
+	bool createContext();
+	bool createFramebuffer();
+
+public:
+	HeadlessContext(int width, int height);
+	~HeadlessContext();
+
+	// false if no context could be created, the reason was printed
+	inline bool isValid() const { return m_Valid; }
+
+	void makeCurrent() const;
+	// binds the offscreen framebuffer and sets the viewport to cover it
+	void bind() const;
+	void resize(int width, int height);
+
+	inline int getWidth() const { return m_Width; }
+	inline int getHeight() const { return m_Height; }
+	unsigned int getFramebuffer() const;
+};
@@ -0,0 +1,234 @@
+#include "ImageDecoder.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+	const size_t s_TgaHeaderSize = 18;
+	const unsigned int s_MaxDimension = 16384;
+
+	enum TgaType : unsigned char {
+		TgaTrueColor = 2,
+		TgaGray = 3,
+		TgaTrueColorRle = 10,
+		TgaGrayRle = 11
+	};
+
+	unsigned int readLE16(const unsigned char* p)
+	{
+		return p[0] | p[1] << 8;
+	}
+
+	bool isTga(const unsigned char* data, size_t size)
+	{
+		if (size < s_TgaHeaderSize || data[1] != 0)		// color mapped images aren't supported
+			return false;
+		unsigned char type = data[2], bits = data[16];
+		if (type == TgaTrueColor || type == TgaTrueColorRle)
+			return bits == 24 || bits == 32;
+		if (type == TgaGray || type == TgaGrayRle)
+			return bits == 8;
+		return false;
+	}
+
+	// one source pixel (BGR, BGRA or gray) to RGBA
+	inline void convertTgaPixel(const unsigned char* src, unsigned int bytes, unsigned char* dst)
+	{
+		if (bytes == 1) {
+			dst[0] = dst[1] = dst[2] = src[0];
+			dst[3] = 255;
+		}
+		else {
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = bytes == 4 ? src[3] : 255;
+		}
+	}
+
+	bool decodeTga(const unsigned char* data, size_t size, const ImageInfo& info, unsigned char* rgba)
+	{
+		unsigned char type = data[2], descriptor = data[17];
+		unsigned int bytes = data[16] / 8;
+		size_t offset = s_TgaHeaderSize + data[0];	// after the image ID
+		size_t pixelCount = (size_t)info.width * info.height;
+		bool rle = type == TgaTrueColorRle || type == TgaGrayRle;
+
+		// decode in file order, then fix the orientation per row
+		unsigned char* dst = rgba;
+		if (!rle) {
+			if (offset + pixelCount * bytes > size)
+				return false;
+			const unsigned char* src = data + offset;
+			for (size_t i = 0; i < pixelCount; i++, src += bytes, dst += 4)
+				convertTgaPixel(src, bytes, dst);
+		}
+		else {
+			size_t written = 0;
+			while (written < pixelCount) {
+				if (offset >= size)
+					return false;
+				unsigned char packet = data[offset++];
+				size_t count = (packet & 0x7f) + 1;
+				if (written + count > pixelCount)
+					return false;
+				if (packet & 0x80) {
+					// run: one pixel repeated
+					if (offset + bytes > size)
+						return false;
+					unsigned char pixel[4];
+					convertTgaPixel(data + offset, bytes, pixel);
+					offset += bytes;
+					for (size_t i = 0; i < count; i++, dst += 4)
+						memcpy(dst, pixel, 4);
+				}
+				else {
+					if (offset + count * bytes > size)
+						return false;
+					for (size_t i = 0; i < count; i++, offset += bytes, dst += 4)
+						convertTgaPixel(data + offset, bytes, dst);
+				}
+				written += count;
+			}
+		}
+
+		size_t rowBytes = (size_t)info.width * 4;
+		if (descriptor & 0x10) {
+			// right to left
+			for (unsigned int y = 0; y < info.height; y++) {
+				unsigned int* row = (unsigned int*)(rgba + y * rowBytes);
+				for (unsigned int x = 0; x < info.width / 2; x++) {
+					unsigned int t = row[x];
+					row[x] = row[info.width - 1 - x];
+					row[info.width - 1 - x] = t;
+				}
+			}
+		}
+		if (descriptor & 0x20) {
+			// top to bottom, GL wants the bottom row first
+			std::vector<unsigned char> row(rowBytes);
+			for (unsigned int y = 0; y < info.height / 2; y++) {
+				unsigned char* a = rgba + y * rowBytes;
+				unsigned char* b = rgba + (info.height - 1 - y) * rowBytes;
+				memcpy(row.data(), a, rowBytes);
+				memcpy(a, b, rowBytes);
+				memcpy(b, row.data(), rowBytes);
+			}
+		}
+		return true;
+	}
+
+	// PNM header fields are ASCII numbers separated by whitespace and # comments
+	bool readPnmNumber(const unsigned char* data, size_t size, size_t& offset, unsigned int& value)
+	{
+		while (offset < size) {
+			if (data[offset] == '#') {
+				while (offset < size && data[offset] != '\n')
+					offset++;
+			}
+			else if (data[offset] == ' ' || data[offset] == '\t' || data[offset] == '\r' || data[offset] == '\n')
+				offset++;
+			else
+				break;
+		}
+		if (offset >= size || data[offset] < '0' || data[offset] > '9')
+			return false;
+		value = 0;
+		while (offset < size && data[offset] >= '0' && data[offset] <= '9' && value <= s_MaxDimension)
+			value = value * 10 + (data[offset++] - '0');
+		return true;
+	}
+
+	bool isPnm(const unsigned char* data, size_t size)
+	{
+		return size >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6');
+	}
+
+	// returns the offset of the pixel data, 0 on error
+	size_t readPnmHeader(const unsigned char* data, size_t size, ImageInfo& info)
+	{
+		size_t offset = 2;
+		unsigned int maxValue = 0;
+		if (!readPnmNumber(data, size, offset, info.width) || !readPnmNumber(data, size, offset, info.height) ||
+			!readPnmNumber(data, size, offset, maxValue) || maxValue != 255)
+			return 0;
+		// exactly one whitespace character before the samples
+		return offset + 1;
+	}
+
+	bool decodePnm(const unsigned char* data, size_t size, const ImageInfo& info, unsigned char* rgba)
+	{
+		ImageInfo header;
+		size_t offset = readPnmHeader(data, size, header);
+		unsigned int channels = data[1] == '6' ? 3 : 1;
+		size_t rowBytes = (size_t)info.width * channels;
+		if (offset == 0 || offset + rowBytes * info.height > size)
+			return false;
+
+		for (unsigned int y = 0; y < info.height; y++) {
+			// PNM rows are stored top to bottom
+			const unsigned char* src = data + offset + (info.height - 1 - y) * rowBytes;
+			unsigned char* dst = rgba + (size_t)y * info.width * 4;
+			for (unsigned int x = 0; x < info.width; x++, src += channels, dst += 4) {
+				dst[0] = src[0];
+				dst[1] = src[channels == 3 ? 1 : 0];
+				dst[2] = src[channels == 3 ? 2 : 0];
+				dst[3] = 255;
+			}
+		}
+		return true;
+	}
+
+}
+
+bool ImageDecoder::readInfo(const unsigned char* data, size_t size, ImageInfo& info)
+{
+	if (isTga(data, size)) {
+		info.width = readLE16(data + 12);
+		info.height = readLE16(data + 14);
+	}
+	else if (isPnm(data, size)) {
+		if (readPnmHeader(data, size, info) == 0)
+			return false;
+	}
+	else
+		return false;
+	return info.width > 0 && info.height > 0 && info.width <= s_MaxDimension && info.height <= s_MaxDimension;
+}
+
+bool ImageDecoder::decode(const unsigned char* data, size_t size, const ImageInfo& info, unsigned char* rgba)
+{
+	if (isTga(data, size))
+		return decodeTga(data, size, info, rgba);
+	if (isPnm(data, size))
+		return decodePnm(data, size, info, rgba);
+	return false;
+}
+
+bool ImageDecoder::writeTga(const char* path, const unsigned char* rgba, unsigned int width, unsigned int height)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	unsigned char header[s_TgaHeaderSize] = {};
+	header[2] = TgaTrueColor;
+	header[12] = width & 0xff;
+	header[13] = (width >> 8) & 0xff;
+	header[14] = height & 0xff;
+	header[15] = (height >> 8) & 0xff;
+	header[16] = 32;
+	header[17] = 8;		// 8 alpha bits, bottom-left origin
+	fwrite(header, 1, sizeof(header), file);
+
+	std::vector<unsigned char> bgra((size_t)width * height * 4);
+	for (size_t i = 0; i < bgra.size(); i += 4) {
+		bgra[i + 0] = rgba[i + 2];
+		bgra[i + 1] = rgba[i + 1];
+		bgra[i + 2] = rgba[i + 0];
+		bgra[i + 3] = rgba[i + 3];
+	}
+	bool written = fwrite(bgra.data(), 1, bgra.size(), file) == bgra.size();
+	return fclose(file) == 0 && written;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+struct ImageInfo {
+	unsigned int width;
+	unsigned int height;
+};
+
+// Decodes the image formats we ship without a third party library: TGA (true color,
+// grayscale, raw or RLE, 8 / 24 / 32 bit) and binary PNM (P5 grayscale, P6 RGB, maxval 255).
+// Output is always tightly packed RGBA8, bottom row first like GL expects. Stateless and
+// thread safe: the texture loader runs it on worker threads.
+class ImageDecoder
+{
+public:
+	// reads only the header, so the caller can size the output
+	static bool readInfo(const unsigned char* data, size_t size, ImageInfo& info);
+	// rgba: info.width * info.height * 4 bytes
+	static bool decode(const unsigned char* data, size_t size, const ImageInfo& info, unsigned char* rgba);
+
+	// uncompressed 32 bit TGA, for tests and tools that generate images
+	static bool writeTga(const char* path, const unsigned char* rgba, unsigned int width, unsigned int height);
+};
@@ -1,10 +1,13 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "Profiler.h"
+#include "FrameCapture.h"
 #include <GL/glew.h>
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
 	: m_Count(count)
 {
+	PROFILE_SCOPE("IndexBuffer::upload");
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
 	GLCall(glGenBuffers(1, &m_RendererID));					
@@ -16,6 +19,8 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
 														// if we use glBindBuffer(GL_ARRAY_BUFFER, 0); then GPU won't draw the triangle out since we bind something else
 
 	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+	Renderer::counters().bytesUploaded += count * sizeof(unsigned int);
+	FrameCapture::onCreateBuffer(m_RendererID, GL_ELEMENT_ARRAY_BUFFER, data, count * sizeof(unsigned int));
 	// above: Set data which we want to use to the specific GPU buffer
 	// : STATIC, DYNAMIC: we should let GPU knows that if the buffer can be modified more than ONCE.
 	// : DRAW: we want to draw things with the buffer, so use it
@@ -23,11 +28,15 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
 
 IndexBuffer::~IndexBuffer()
 {
+	FrameCapture::onDeleteBuffer(m_RendererID);
 	GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void IndexBuffer::bind() const
 {
+	Renderer::counters().indexBufferBinds++;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));// How do I want to use the GL Buffer? Define it to a specific buffer:
 														//	target - GL_ARRAY_BUFFER: it's just an array
 														//	buffer - an integer comes from memory
@@ -37,6 +46,8 @@ void IndexBuffer::bind() const
 
 void IndexBuffer::unbind() const
 {
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));		// How do I want to use the GL Buffer? Define it to a specific buffer:
 													//	target - GL_ARRAY_BUFFER: it's just an array
 													//	buffer - an integer comes from memory
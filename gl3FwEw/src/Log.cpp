@@ -0,0 +1,276 @@
+#include "Log.h"
+#include "Profiler.h"
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+	// One queued message, 256 bytes. sequence tells producers and the consumer whose turn
+	// it is: (lap) = free for the producer of that lap, (lap + 1) = published. A lap is
+	// pos & ~(QueueSize - 1), so the zero-initialized array is already a valid empty queue.
+	struct alignas(64) Slot {
+		std::atomic<unsigned long long> sequence;
+		unsigned long long time;
+		std::string* overflow;		// the message if it didn't fit into text
+		unsigned int length;
+		unsigned short thread;
+		unsigned char level;
+		char text[Log::SlotText];
+	};
+
+	const unsigned long long QueueMask = Log::QueueSize - 1;
+
+	Slot s_Slots[Log::QueueSize];
+	std::atomic<unsigned long long> s_Tail(0);		// next position a producer claims
+	unsigned long long s_Head = 0;					// next position to drain, the consumer's alone
+	std::atomic<unsigned long long> s_Written(0);	// drained so far, for flush()
+	std::atomic<unsigned long long> s_Dropped(0);
+
+	std::mutex s_IoMutex;			// guards s_File and the synchronous fallback
+	FILE* s_File = nullptr;			// null = stderr
+
+	std::mutex s_WakeMutex;
+	std::condition_variable s_Wake;
+	std::atomic<bool> s_Sleeping(false);
+	std::atomic<bool> s_Running(false);
+	std::atomic<bool> s_Stopped(false);	// after shutdown(), write synchronously
+	std::once_flag s_StartOnce;
+	std::thread s_Thread;
+
+	std::atomic<unsigned short> s_NextThread(1);
+	thread_local unsigned short t_Thread = 0;
+
+	inline unsigned short getThread()
+	{
+		if (!t_Thread)
+			t_Thread = s_NextThread.fetch_add(1);
+		return t_Thread;
+	}
+
+	const char* getLevelName(int level)
+	{
+		static const char* names[] = { "trace", "debug", "info ", "warn ", "error" };
+		return level >= 0 && level < 5 ? names[level] : "?    ";
+	}
+
+	// s_IoMutex must be held
+	void writeLine(unsigned long long time, int level, unsigned short thread, const char* text, unsigned int length)
+	{
+		FILE* file = s_File ? s_File : stderr;
+		fprintf(file, "[%10.3f] [%s] [T%u] ", time / 1e6, getLevelName(level), thread);
+		fwrite(text, 1, length, file);
+		if (length == 0 || text[length - 1] != '\n')
+			fputc('\n', file);
+	}
+
+	// writes every published slot, returns how many; only one thread drains at a time
+	unsigned int drain()
+	{
+		unsigned int count = 0;
+		std::lock_guard<std::mutex> lock(s_IoMutex);
+		for (;;) {
+			Slot& slot = s_Slots[s_Head & QueueMask];
+			if (slot.sequence.load(std::memory_order_acquire) != (s_Head & ~QueueMask) + 1)
+				break;
+
+			if (slot.overflow) {
+				writeLine(slot.time, slot.level, slot.thread, slot.overflow->data(), (unsigned int)slot.overflow->size());
+				delete slot.overflow;
+				slot.overflow = nullptr;
+			}
+			else
+				writeLine(slot.time, slot.level, slot.thread, slot.text, slot.length);
+
+			slot.sequence.store((s_Head & ~QueueMask) + Log::QueueSize, std::memory_order_release);
+			s_Head++;
+			count++;
+		}
+
+		if (unsigned long long dropped = s_Dropped.exchange(0, std::memory_order_relaxed)) {
+			char text[64];
+			int length = snprintf(text, sizeof(text), "%llu messages dropped, the log queue was full", dropped);
+			writeLine(Profiler::now(), (int)LogLevel::Warn, 0, text, (unsigned int)length);
+		}
+		if (count)
+			fflush(s_File ? s_File : stderr);
+		s_Written.store(s_Head, std::memory_order_release);
+		return count;
+	}
+
+	void run()
+	{
+		while (s_Running.load(std::memory_order_acquire)) {
+			if (drain())
+				continue;
+			std::unique_lock<std::mutex> lock(s_WakeMutex);
+			s_Sleeping.store(true, std::memory_order_seq_cst);
+			// producers only notify when they see s_Sleeping, the timeout covers the race
+			s_Wake.wait_for(lock, std::chrono::milliseconds(10));
+			s_Sleeping.store(false, std::memory_order_relaxed);
+		}
+		drain();
+	}
+
+	void start()
+	{
+		s_Running.store(true, std::memory_order_release);
+		s_Thread = std::thread(run);
+	}
+
+	void wake()
+	{
+		if (s_Sleeping.exchange(false, std::memory_order_seq_cst)) {
+			std::lock_guard<std::mutex> lock(s_WakeMutex);
+			s_Wake.notify_one();
+		}
+	}
+
+	// joins the thread before the statics above it are destroyed
+	struct ShutdownAtExit {
+		~ShutdownAtExit() { Log::shutdown(); }
+	} s_ShutdownAtExit;
+
+}
+
+std::atomic<int> Log::s_Level((int)LogLevel::Info);
+
+void Log::setLevel(LogLevel level)
+{
+	s_Level.store((int)level, std::memory_order_relaxed);
+}
+
+bool Log::setFile(const std::string& filepath)
+{
+	FILE* file = nullptr;
+	if (!filepath.empty()) {
+		file = fopen(filepath.c_str(), "w");
+		if (!file) {
+			LOG_ERROR("Failed to open '%s' for the log", filepath.c_str());
+			return false;
+		}
+	}
+
+	flush();
+	std::lock_guard<std::mutex> lock(s_IoMutex);
+	if (s_File)
+		fclose(s_File);
+	s_File = file;
+	return true;
+}
+
+void Log::write(LogLevel level, const char* format, ...)
+{
+	unsigned long long time = Profiler::now();
+
+	if (s_Stopped.load(std::memory_order_acquire)) {
+		char text[SlotText];
+		va_list args;
+		va_start(args, format);
+		va_list retry;
+		va_copy(retry, args);
+		int length = vsnprintf(text, sizeof(text), format, args);
+		va_end(args);
+		std::string overflow;
+		if (length >= (int)SlotText) {
+			overflow.resize((size_t)length);
+			vsnprintf(&overflow[0], (size_t)length + 1, format, retry);
+		}
+		va_end(retry);
+		std::lock_guard<std::mutex> lock(s_IoMutex);
+		writeLine(time, (int)level, getThread(), overflow.empty() ? text : overflow.data(), length < 0 ? 0 : (unsigned int)length);
+		fflush(s_File ? s_File : stderr);
+		return;
+	}
+	std::call_once(s_StartOnce, start);
+
+	// claim a slot
+	unsigned long long pos = s_Tail.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &s_Slots[pos & QueueMask];
+		long long diff = (long long)(slot->sequence.load(std::memory_order_acquire) - (pos & ~QueueMask));
+		if (diff == 0) {
+			if (s_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) {
+			// full: drop the chatter, wait for the consumer on warnings and errors
+			if (level < LogLevel::Warn) {
+				s_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			wake();
+			std::this_thread::yield();
+			pos = s_Tail.load(std::memory_order_relaxed);
+		}
+		else
+			pos = s_Tail.load(std::memory_order_relaxed);
+	}
+
+	va_list args;
+	va_start(args, format);
+	va_list retry;
+	va_copy(retry, args);
+	int length = vsnprintf(slot->text, SlotText, format, args);
+	va_end(args);
+	if (length < 0)
+		length = 0;
+	slot->overflow = nullptr;
+	if ((unsigned int)length >= SlotText) {
+		slot->overflow = new std::string((size_t)length, '\0');
+		vsnprintf(&(*slot->overflow)[0], (size_t)length + 1, format, retry);
+	}
+	va_end(retry);
+
+	slot->time = time;
+	slot->length = (unsigned int)length;
+	slot->thread = getThread();
+	slot->level = (unsigned char)level;
+	slot->sequence.store((pos & ~QueueMask) + 1, std::memory_order_release);
+
+	if (level >= LogLevel::Error)
+		flush();
+	else if (level >= LogLevel::Warn || (pos & (QueueSize / 4 - 1)) == 0)
+		wake();
+}
+
+void Log::flush()
+{
+	unsigned long long target = s_Tail.load(std::memory_order_acquire);
+	if (!s_Running.load(std::memory_order_acquire)) {
+		// no consumer (never started or shut down), drain on this thread
+		if (s_Stopped.load(std::memory_order_acquire))
+			drain();
+		return;
+	}
+	while (s_Written.load(std::memory_order_acquire) < target) {
+		wake();
+		std::this_thread::yield();
+	}
+}
+
+void Log::shutdown()
+{
+	if (s_Stopped.exchange(true, std::memory_order_acq_rel))
+		return;
+	// waits for a start() in progress, and keeps one from happening later
+	std::call_once(s_StartOnce, []() {});
+	if (s_Running.exchange(false, std::memory_order_acq_rel)) {
+		{
+			std::lock_guard<std::mutex> lock(s_WakeMutex);
+			s_Wake.notify_one();
+		}
+		s_Thread.join();
+	}
+	// a producer may have published between the thread's last drain and now
+	drain();
+
+	std::lock_guard<std::mutex> lock(s_IoMutex);
+	if (s_File) {
+		fclose(s_File);
+		s_File = nullptr;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+enum class LogLevel : int {
+	Trace = 0,
+	Debug,
+	Info,
+	Warn,
+	Error,
+	Off
+};
+
+// Compile-time floor: messages below LOG_MIN_LEVEL compile to nothing, arguments included.
+// Defaults to Debug, or Info in NDEBUG builds. Build with LOG_MIN_LEVEL=5 to strip all of them.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 2
+#else
+#define LOG_MIN_LEVEL 1
+#endif
+#endif
+
+// Asynchronous logger. write() formats into a slot of a preallocated lock-free queue
+// and returns; a background thread drains the queue to stderr or a file. The calling
+// thread never waits for I/O, except on Error: those flush before returning so the
+// message is out before an ASSERT breaks. When the queue is full, messages below Warn
+// are dropped and counted instead of blocking the caller.
+class Log
+{
+public:
+	static const unsigned int QueueSize = 4096;	// slots, a power of two
+	static const unsigned int SlotText = 224;	// longer messages go to the heap
+
+	// runtime floor on top of LOG_MIN_LEVEL, Info by default
+	static void setLevel(LogLevel level);
+	static inline LogLevel getLevel() { return (LogLevel)s_Level.load(std::memory_order_relaxed); }
+	static inline bool isEnabled(LogLevel level) { return (int)level >= s_Level.load(std::memory_order_relaxed); }
+
+	// empty path = stderr (the default); false if the file can't be opened
+	static bool setFile(const std::string& filepath);
+
+	// printf-style; use the LOG_* macros so stripped levels cost nothing
+	static void write(LogLevel level, const char* format, ...)
+#if defined(__GNUC__)
+		__attribute__((format(printf, 2, 3)))
+#endif
+		;
+
+	// blocks until everything logged so far is written
+	static void flush();
+	// flushes and stops the background thread; logging afterwards writes synchronously
+	static void shutdown();
+
+private:
+	static std::atomic<int> s_Level;
+};
+
+#define LOG_AT(level, ...) (Log::isEnabled(level) ? Log::write(level, __VA_ARGS__) : (void)0)
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_TRACE(...) LOG_AT(LogLevel::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 3
+#define LOG_WARN(...) LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 4
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A read-only memory mapping of a whole file: the OS pages it in as it's read, nothing
+// is copied into the process up front.
+class MappedFile
+{
+private:
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;		// HANDLE
+	void* m_Mapping;	// HANDLE
+#endif
+
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// false if the file couldn't be opened or mapped, or is empty
+	inline bool isValid() const { return m_Data != nullptr; }
+	inline const unsigned char* getData() const { return m_Data; }
+	inline size_t getSize() const { return m_Size; }
+};
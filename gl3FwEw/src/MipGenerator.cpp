@@ -0,0 +1,369 @@
+#include "MipGenerator.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIP_AVX2 1
+#define MIP_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_SSE2 1
+#endif
+
+namespace {
+
+	const float s_KaiserRadius = 3.0f;		// in destination texels
+	const float s_KaiserAlpha = 4.0f;
+	// below this many destination floats a level isn't worth a thread
+	const size_t s_MinParallelWork = 64 * 1024;
+	const unsigned int s_SrgbTableSize = 16384;
+
+	// source texels and weights of every destination texel along one axis, count per texel
+	struct Taps {
+		unsigned int count;
+		std::vector<unsigned int> index;	// edge handling already applied
+		std::vector<float> weight;
+	};
+
+	float besselI0(float x)
+	{
+		// power series, converges fast for the arguments a Kaiser window uses
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 20; k++) {
+			term *= (x * 0.5f / k) * (x * 0.5f / k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float kaiser(float d)
+	{
+		// sinc windowed by a Kaiser window of radius s_KaiserRadius
+		float t = d / s_KaiserRadius;
+		if (t <= -1.0f || t >= 1.0f)
+			return 0.0f;
+		float sinc = d == 0.0f ? 1.0f : std::sin(3.14159265f * d) / (3.14159265f * d);
+		return sinc * besselI0(s_KaiserAlpha * std::sqrt(1.0f - t * t)) / besselI0(s_KaiserAlpha);
+	}
+
+	unsigned int resolveIndex(int index, unsigned int size, bool wrap)
+	{
+		if (wrap)
+			return (unsigned int)(((index % (int)size) + (int)size) % (int)size);
+		return (unsigned int)std::min(std::max(index, 0), (int)size - 1);
+	}
+
+	// unnormalized weights of destination texel o, source indices before edge handling
+	void collectTaps(unsigned int o, float scale, MipFilter filter, std::vector<std::pair<int, float>>& taps)
+	{
+		taps.clear();
+		if (filter == MipFilter::Box || scale == 1.0f) {
+			// area of each source texel under the destination texel
+			float low = o * scale, high = (o + 1) * scale;
+			for (int i = (int)std::floor(low); i < (int)std::ceil(high); i++) {
+				float area = std::min(high, i + 1.0f) - std::max(low, (float)i);
+				if (area > 0.0f)
+					taps.push_back({ i, area });
+			}
+		}
+		else {
+			float center = (o + 0.5f) * scale, radius = s_KaiserRadius * scale;
+			for (int i = (int)std::floor(center - radius); i <= (int)std::ceil(center + radius); i++) {
+				float weight = kaiser((i + 0.5f - center) / scale);
+				if (weight != 0.0f)
+					taps.push_back({ i, weight });
+			}
+		}
+	}
+
+	Taps makeTaps(unsigned int srcSize, unsigned int dstSize, MipFilter filter, bool wrap)
+	{
+		float scale = (float)srcSize / dstSize;
+		std::vector<std::pair<int, float>> taps;
+		// the same count for every texel, padded with zero weights, so the kernels have no branches
+		Taps result;
+		result.count = 0;
+		for (unsigned int o = 0; o < dstSize; o++) {
+			collectTaps(o, scale, filter, taps);
+			result.count = std::max(result.count, (unsigned int)taps.size());
+		}
+		result.index.resize((size_t)dstSize * result.count);
+		result.weight.resize((size_t)dstSize * result.count, 0.0f);
+		for (unsigned int o = 0; o < dstSize; o++) {
+			collectTaps(o, scale, filter, taps);
+			float sum = 0.0f;
+			for (const std::pair<int, float>& tap : taps)
+				sum += tap.second;
+			for (unsigned int k = 0; k < result.count; k++) {
+				size_t slot = (size_t)o * result.count + k;
+				result.index[slot] = resolveIndex(taps[k < taps.size() ? k : 0].first, srcSize, wrap);
+				result.weight[slot] = k < taps.size() ? taps[k].second / sum : 0.0f;
+			}
+		}
+		return result;
+	}
+
+	// runs function(begin, end) over [0, rows) in bands, one band per thread
+	template<typename Function>
+	void parallelRows(unsigned int rows, size_t work, unsigned int threads, const Function& function)
+	{
+		unsigned int bands = std::min(threads, rows);
+		if (bands <= 1 || work < s_MinParallelWork) {
+			function(0u, rows);
+			return;
+		}
+		std::vector<std::thread> workers;
+		workers.reserve(bands - 1);
+		for (unsigned int band = 1; band < bands; band++)
+			workers.emplace_back(function, (unsigned int)((unsigned long long)rows * band / bands), (unsigned int)((unsigned long long)rows * (band + 1) / bands));
+		function(0u, (unsigned int)((unsigned long long)rows / bands));
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// one row, source width -> destination width, one RGBA texel at a time
+	void filterRow(const float* src, float* dst, unsigned int dstWidth, const Taps& taps)
+	{
+		const unsigned int* index = taps.index.data();
+		const float* weight = taps.weight.data();
+		for (unsigned int x = 0; x < dstWidth; x++, index += taps.count, weight += taps.count) {
+#if MIP_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for (unsigned int k = 0; k < taps.count; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + index[k] * 4)));
+			_mm_storeu_ps(dst + x * 4, sum);
+#else
+			float sum[4] = {};
+			for (unsigned int k = 0; k < taps.count; k++)
+				for (int c = 0; c < 4; c++)
+					sum[c] += weight[k] * src[index[k] * 4 + c];
+			for (int c = 0; c < 4; c++)
+				dst[x * 4 + c] = sum[c];
+#endif
+		}
+	}
+
+	// destination rows [begin, end): weighted sums of whole source rows, floats side by side
+	void filterColumns(const float* src, float* dst, unsigned int width, const Taps& taps, unsigned int begin, unsigned int end)
+	{
+		size_t floats = (size_t)width * 4;
+		for (unsigned int y = begin; y < end; y++) {
+			const unsigned int* index = taps.index.data() + (size_t)y * taps.count;
+			const float* weight = taps.weight.data() + (size_t)y * taps.count;
+			float* dstRow = dst + y * floats;
+			size_t i = 0;
+#if MIP_AVX2
+			for (; i + 8 <= floats; i += 8) {
+				__m256 sum = _mm256_setzero_ps();
+				for (unsigned int k = 0; k < taps.count; k++)
+					sum = _mm256_fmadd_ps(_mm256_set1_ps(weight[k]), _mm256_loadu_ps(src + index[k] * floats + i), sum);
+				_mm256_storeu_ps(dstRow + i, sum);
+			}
+#endif
+#if MIP_SSE2
+			// width * 4 floats, always a multiple of 4
+			for (; i < floats; i += 4) {
+				__m128 sum = _mm_setzero_ps();
+				for (unsigned int k = 0; k < taps.count; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(src + index[k] * floats + i)));
+				_mm_storeu_ps(dstRow + i, sum);
+			}
+#else
+			for (; i < floats; i++) {
+				float sum = 0.0f;
+				for (unsigned int k = 0; k < taps.count; k++)
+					sum += weight[k] * src[index[k] * floats + i];
+				dstRow[i] = sum;
+			}
+#endif
+		}
+	}
+
+	// keeps the chain in range (the Kaiser lobes ring) or unit length
+	void fixupTexels(float* texels, size_t count, MipContent content)
+	{
+		if (content != MipContent::NormalMap) {
+			size_t i = 0;
+#if MIP_SSE2
+			__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+			for (; i < count * 4; i += 4)
+				_mm_storeu_ps(texels + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texels + i), zero), one));
+#endif
+			for (; i < count * 4; i++)
+				texels[i] = std::min(std::max(texels[i], 0.0f), 1.0f);
+			return;
+		}
+		for (size_t i = 0; i < count; i++) {
+			float* texel = texels + i * 4;
+			float length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+			if (length > 1e-6f) {
+				texel[0] /= length;
+				texel[1] /= length;
+				texel[2] /= length;
+			}
+			else {
+				texel[0] = texel[1] = 0.0f;
+				texel[2] = 1.0f;
+			}
+			texel[3] = std::min(std::max(texel[3], 0.0f), 1.0f);
+		}
+	}
+
+	// linear -> 8 bit sRGB, fine enough to still round right where the curve is steepest
+	struct SrgbTable {
+		unsigned char values[s_SrgbTableSize + 1];
+
+		SrgbTable()
+		{
+			for (unsigned int i = 0; i <= s_SrgbTableSize; i++) {
+				float c = (float)i / s_SrgbTableSize;
+				float srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+				values[i] = (unsigned char)(srgb * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	// byte -> filtering space, per channel
+	struct ByteTable {
+		float values[4][256];
+	};
+
+	void makeByteTable(MipContent content, ByteTable& table)
+	{
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			float linear = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			table.values[0][i] = table.values[1][i] = table.values[2][i] =
+				content == MipContent::SRGB ? linear : content == MipContent::NormalMap ? c * 2.0f - 1.0f : c;
+			table.values[3][i] = c;
+		}
+	}
+
+	void toFloat(const unsigned char* rgba, size_t count, const ByteTable& table, float* texels)
+	{
+		for (size_t i = 0; i < count * 4; i += 4) {
+			texels[i + 0] = table.values[0][rgba[i + 0]];
+			texels[i + 1] = table.values[1][rgba[i + 1]];
+			texels[i + 2] = table.values[2][rgba[i + 2]];
+			texels[i + 3] = table.values[3][rgba[i + 3]];
+		}
+	}
+
+	void toBytes(const float* texels, size_t begin, size_t end, MipContent content, unsigned char* rgba)
+	{
+		static const SrgbTable s_Srgb;
+		size_t i = begin * 4;
+#if MIP_SSE2
+		if (content != MipContent::SRGB) {
+			// normals: xyz * 0.5 + 0.5, alpha as is
+			__m128 scale = content == MipContent::NormalMap ? _mm_setr_ps(127.5f, 127.5f, 127.5f, 255.0f) : _mm_set1_ps(255.0f);
+			__m128 bias = content == MipContent::NormalMap ? _mm_setr_ps(128.0f, 128.0f, 128.0f, 0.5f) : _mm_set1_ps(0.5f);
+			for (; i < end * 4; i += 4) {
+				__m128i value = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(texels + i), scale), bias));
+				value = _mm_packs_epi32(value, value);
+				value = _mm_packus_epi16(value, value);
+				int packed = _mm_cvtsi128_si32(value);
+				rgba[i + 0] = (unsigned char)packed;
+				rgba[i + 1] = (unsigned char)(packed >> 8);
+				rgba[i + 2] = (unsigned char)(packed >> 16);
+				rgba[i + 3] = (unsigned char)(packed >> 24);
+			}
+		}
+#endif
+		for (; i < end * 4; i++) {
+			float c = texels[i];
+			if ((i & 3) == 3 || content == MipContent::Linear)
+				rgba[i] = (unsigned char)(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+			else if (content == MipContent::SRGB)
+				rgba[i] = s_Srgb.values[(unsigned int)(std::min(std::max(c, 0.0f), 1.0f) * s_SrgbTableSize + 0.5f)];
+			else
+				rgba[i] = (unsigned char)(std::min(std::max(c, -1.0f), 1.0f) * 127.5f + 128.0f);
+		}
+	}
+
+	unsigned int getLevelSize(unsigned int size, unsigned int level)
+	{
+		size >>= level;
+		return size > 0 ? size : 1;
+	}
+
+}
+
+bool MipGenerator::generate(const unsigned char* rgba, unsigned int width, unsigned int height, const MipSettings& settings,
+	std::vector<std::vector<unsigned char>>& levels)
+{
+	PROFILE_SCOPE("MipGenerator::generate");
+	if (!rgba || width == 0 || height == 0)
+		return false;
+	unsigned int threads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+	unsigned int levelCount = Texture::getMaxLevels(width, height);
+	levels.resize(levelCount);
+	levels[0].assign(rgba, rgba + (size_t)width * height * 4);
+
+	ByteTable table;
+	makeByteTable(settings.content, table);
+	// level 0 is never converted as a whole: its rows go to float one at a time, right
+	// before they're filtered
+	std::vector<float> current, next, rows;
+	for (unsigned int level = 1; level < levelCount; level++) {
+		unsigned int srcWidth = getLevelSize(width, level - 1), srcHeight = getLevelSize(height, level - 1);
+		unsigned int dstWidth = getLevelSize(width, level), dstHeight = getLevelSize(height, level);
+		Taps horizontal = makeTaps(srcWidth, dstWidth, settings.filter, settings.wrap);
+		Taps vertical = makeTaps(srcHeight, dstHeight, settings.filter, settings.wrap);
+
+		// narrow every source row first, then combine the narrowed rows
+		rows.resize((size_t)dstWidth * srcHeight * 4);
+		next.resize((size_t)dstWidth * dstHeight * 4);
+		parallelRows(srcHeight, rows.size() * horizontal.count, threads, [&](unsigned int begin, unsigned int end) {
+			std::vector<float> scratch(level == 1 ? (size_t)srcWidth * 4 : 0);
+			for (unsigned int y = begin; y < end; y++) {
+				// current is still empty at level 1, don't offset into it
+				const float* srcRow;
+				if (level == 1) {
+					toFloat(rgba + (size_t)y * srcWidth * 4, srcWidth, table, scratch.data());
+					srcRow = scratch.data();
+				}
+				else {
+					srcRow = current.data() + (size_t)y * srcWidth * 4;
+				}
+				filterRow(srcRow, rows.data() + (size_t)y * dstWidth * 4, dstWidth, horizontal);
+			}
+		});
+		std::vector<unsigned char>& output = levels[level];
+		output.resize((size_t)dstWidth * dstHeight * 4);
+		parallelRows(dstHeight, next.size() * vertical.count, threads, [&](unsigned int begin, unsigned int end) {
+			filterColumns(rows.data(), next.data(), dstWidth, vertical, begin, end);
+			size_t first = (size_t)begin * dstWidth, last = (size_t)end * dstWidth;
+			fixupTexels(next.data() + first * 4, last - first, settings.content);
+			toBytes(next.data(), first, last, settings.content, output.data());
+		});
+		current.swap(next);
+	}
+	return true;
+}
+
+std::unique_ptr<Texture2D> MipGenerator::createTexture(const unsigned char* rgba, unsigned int width, unsigned int height, const MipSettings& settings)
+{
+	std::vector<std::vector<unsigned char>> levels;
+	if (!generate(rgba, width, height, settings, levels))
+		return nullptr;
+	TextureFormat format = settings.content == MipContent::SRGB ? TextureFormat::SRGB8_Alpha8 : TextureFormat::RGBA8;
+	std::unique_ptr<Texture2D> texture(new Texture2D(width, height, format, (unsigned int)levels.size()));
+	for (unsigned int level = 0; level < levels.size(); level++)
+		texture->setData(levels[level].data(), level);
+	return texture;
+}
+
+const char* MipGenerator::getKernelName()
+{
+#if MIP_AVX2
+	return "avx2";
+#elif MIP_SSE2
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Texture.h"
+#include <memory>
+#include <vector>
+
+enum class MipFilter : unsigned char {
+	Box,		// exact area average, 2x2 for even sizes
+	Kaiser		// Kaiser windowed sinc, sharper, 12 taps per axis
+};
+
+enum class MipContent : unsigned char {
+	Linear,		// filtered as stored
+	SRGB,		// rgb linearized before filtering and re-encoded after, alpha linear
+	NormalMap	// rgb = xyz * 0.5 + 0.5, renormalized on every level, alpha linear
+};
+
+struct MipSettings {
+	MipFilter filter;
+	MipContent content;
+	bool wrap;				// tiling texture: filter taps wrap around instead of clamping
+	unsigned int threads;	// 0 = one per hardware thread
+
+	static MipSettings color(MipFilter filter = MipFilter::Box) { return { filter, MipContent::SRGB, false, 0 }; }
+	static MipSettings normalMap(MipFilter filter = MipFilter::Box) { return { filter, MipContent::NormalMap, false, 0 }; }
+};
+
+// CPU mip chain generation, for the asset cook and for textures made at runtime, where
+// glGenerateMipmap (box filter in whatever space the driver picks, no idea what a normal
+// map is) isn't good enough. The chain is kept in float, each level filtered from the
+// previous one with separable SSE kernels (the vertical pass 8 wide in AVX2 builds, see
+// GL3FWEW_AVX2) and only quantized on output; the rows of a level are split across threads.
+class MipGenerator
+{
+public:
+	// rgba: tightly packed RGBA8; levels gets the full chain down to 1x1, level 0 included
+	static bool generate(const unsigned char* rgba, unsigned int width, unsigned int height, const MipSettings& settings,
+		std::vector<std::vector<unsigned char>>& levels);
+	// generate() and upload every level: SRGB8_Alpha8 for sRGB content, RGBA8 otherwise
+	static std::unique_ptr<Texture2D> createTexture(const unsigned char* rgba, unsigned int width, unsigned int height, const MipSettings& settings);
+
+	// "avx2", "sse2" or "scalar", what the kernels were compiled for
+	static const char* getKernelName();
+};
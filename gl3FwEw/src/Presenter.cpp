@@ -0,0 +1,82 @@
+#include "Presenter.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <cstdlib>
+#include <cstring>
+
+Presenter::Presenter(GLFWwindow* window, PresentMode mode, double targetFps)
+	: m_Window(window), m_Mode(mode)
+{
+	setMode(mode, targetFps);
+}
+
+void Presenter::setMode(PresentMode mode, double targetFps)
+{
+	if (mode == PresentMode::AdaptiveVSync && !isAdaptiveSupported()) {
+		LOG_WARN("Adaptive vsync isn't supported, falling back to vsync");
+		mode = PresentMode::VSync;
+	}
+	if (mode == PresentMode::Limited && targetFps <= 0.0)
+		mode = PresentMode::Uncapped;
+
+	m_Mode = mode;
+	switch (mode) {
+		case PresentMode::Uncapped:			glfwSwapInterval(0);	break;
+		case PresentMode::VSync:			glfwSwapInterval(1);	break;
+		case PresentMode::AdaptiveVSync:	glfwSwapInterval(-1);	break;
+		case PresentMode::Limited:			glfwSwapInterval(0);	break;
+	}
+	// above code:
+	// : interval - The minimum number of screen updates to wait for until the buffers are swapped by glfwSwapBuffers.
+	// : a negative interval swaps immediately if the frame missed the refresh (EXT_swap_control_tear)
+
+	m_Limiter.setTargetFps(mode == PresentMode::Limited ? targetFps : 0.0);
+}
+
+void Presenter::present()
+{
+	PROFILE_SCOPE("Presenter::present");
+	{
+		PROFILE_SCOPE("SwapBuffers");
+		glfwSwapBuffers(m_Window);
+	}
+	{
+		PROFILE_SCOPE("FrameLimiter::wait");
+		m_Limiter.wait();
+	}
+}
+
+bool Presenter::isAdaptiveSupported()
+{
+	return glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+		glfwExtensionSupported("GLX_EXT_swap_control_tear");
+}
+
+const char* Presenter::getModeName(PresentMode mode)
+{
+	switch (mode) {
+		case PresentMode::Uncapped:			return "uncapped";
+		case PresentMode::VSync:			return "vsync";
+		case PresentMode::AdaptiveVSync:	return "adaptive";
+		case PresentMode::Limited:			return "limited";
+	}
+	return "unknown";
+}
+
+bool Presenter::parseMode(const char* text, PresentMode& mode, double& targetFps)
+{
+	targetFps = 0.0;
+	if (strcmp(text, "uncapped") == 0)			mode = PresentMode::Uncapped;
+	else if (strcmp(text, "vsync") == 0)		mode = PresentMode::VSync;
+	else if (strcmp(text, "adaptive") == 0)		mode = PresentMode::AdaptiveVSync;
+	else {
+		char* end = nullptr;
+		targetFps = strtod(text, &end);
+		if (end == text || *end != '\0' || targetFps <= 0.0)
+			return false;
+		mode = PresentMode::Limited;
+	}
+	return true;
+}
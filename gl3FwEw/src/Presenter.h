@@ -0,0 +1,36 @@
+#pragma once
+
+#include "FrameLimiter.h"
+
+struct GLFWwindow;
+
+enum class PresentMode {
+	Uncapped,		// swap interval 0, for benchmarks
+	VSync,			// swap interval 1
+	AdaptiveVSync,	// swap interval -1: tear instead of waiting a whole refresh when late
+	Limited			// swap interval 0 + software frame limiter
+};
+
+// Owns the presentation policy of a window: swap interval and optional frame cap.
+class Presenter
+{
+private:
+	GLFWwindow* m_Window;
+	PresentMode m_Mode;
+	FrameLimiter m_Limiter;
+
+public:
+	Presenter(GLFWwindow* window, PresentMode mode = PresentMode::VSync, double targetFps = 0.0);
+
+	// the window's context has to be current
+	void setMode(PresentMode mode, double targetFps = 0.0);
+	inline PresentMode getMode() const { return m_Mode; }
+
+	// swap buffers and wait out the rest of the frame if we're limited
+	void present();
+
+	static bool isAdaptiveSupported();
+	static const char* getModeName(PresentMode mode);
+	// parses "uncapped", "vsync", "adaptive" or "<fps>" (e.g. "30"); returns false on garbage
+	static bool parseMode(const char* text, PresentMode& mode, double& targetFps);
+};
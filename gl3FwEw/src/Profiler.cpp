@@ -0,0 +1,242 @@
+#include "Profiler.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// One per thread that ever recorded, plus one per createTrack(). Only one thread
+// writes; head is published with release so the exporter sees whole events.
+// Never freed, the events must outlive the thread for the export.
+struct ProfileTrack {
+	ProfileEvent events[Profiler::EventsPerThread];
+	std::atomic<unsigned long long> head;	// total events written
+	unsigned int id;
+	unsigned int depth;
+	char name[32];
+	ProfileTrack* next;
+};
+
+namespace {
+
+	std::atomic<ProfileTrack*> s_Tracks(nullptr);
+	std::atomic<unsigned int> s_NextTrackID(1);
+
+	const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+	// start time of the last MaxFrames frames, written by markFrame() only
+	unsigned long long s_FrameStarts[Profiler::MaxFrames];
+	std::atomic<unsigned long long> s_FrameCount(0);
+
+	thread_local ProfileTrack* t_Track = nullptr;
+
+	ProfileTrack* registerTrack(const char* name)
+	{
+		ProfileTrack* track = new ProfileTrack();
+		track->head.store(0, std::memory_order_relaxed);
+		track->id = s_NextTrackID.fetch_add(1);
+		track->depth = 0;
+		if (name)
+			snprintf(track->name, sizeof(track->name), "%s", name);
+		else
+			snprintf(track->name, sizeof(track->name), "Thread %u", track->id);
+
+		// lock-free push onto the registry
+		track->next = s_Tracks.load(std::memory_order_relaxed);
+		while (!s_Tracks.compare_exchange_weak(track->next, track, std::memory_order_release, std::memory_order_relaxed));
+		return track;
+	}
+
+	ProfileTrack* getThreadTrack()
+	{
+		if (!t_Track)
+			t_Track = registerTrack(nullptr);
+		return t_Track;
+	}
+
+	void append(ProfileTrack* track, const ProfileEvent& event)
+	{
+		unsigned long long head = track->head.load(std::memory_order_relaxed);
+		track->events[head % Profiler::EventsPerThread] = event;
+		track->head.store(head + 1, std::memory_order_release);
+	}
+
+	// copies what's still buffered, then drops whatever the writer overwrote while we were copying
+	void snapshot(ProfileTrack* track, std::vector<ProfileEvent>& events)
+	{
+		unsigned long long head = track->head.load(std::memory_order_acquire);
+		unsigned long long first = head > Profiler::EventsPerThread ? head - Profiler::EventsPerThread : 0;
+		events.clear();
+		for (unsigned long long i = first; i < head; i++)
+			events.push_back(track->events[i % Profiler::EventsPerThread]);
+
+		unsigned long long newHead = track->head.load(std::memory_order_acquire);
+		unsigned long long overwritten = newHead > Profiler::EventsPerThread + first ? newHead - Profiler::EventsPerThread - first : 0;
+		events.erase(events.begin(), events.begin() + (size_t)std::min<unsigned long long>(overwritten, events.size()));
+	}
+
+	void writeEscaped(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c; c++) {
+			if (*c == '"' || *c == '\\')
+				fputc('\\', file);
+			if ((unsigned char)*c >= 0x20)
+				fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+
+}
+
+std::atomic<bool> Profiler::s_Enabled(false);
+
+void Profiler::setEnabled(bool enabled)
+{
+	s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+	ProfileTrack* track = getThreadTrack();
+	snprintf(track->name, sizeof(track->name), "%s", name);
+}
+
+void Profiler::markFrame()
+{
+	unsigned long long frame = s_FrameCount.load(std::memory_order_relaxed);
+	s_FrameStarts[frame % MaxFrames] = now();
+	s_FrameCount.store(frame + 1, std::memory_order_release);
+}
+
+unsigned long long Profiler::getFrameIndex()
+{
+	unsigned long long count = s_FrameCount.load(std::memory_order_acquire);
+	return count > 0 ? count - 1 : 0;
+}
+
+unsigned long long Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count();
+}
+
+unsigned long long Profiler::enterScope()
+{
+	getThreadTrack()->depth++;
+	return now();
+}
+
+void Profiler::leaveScope(const char* name, unsigned long long begin)
+{
+	ProfileEvent event;
+	event.name = name;
+	event.begin = begin;
+	event.end = now();
+	event.frame = getFrameIndex();
+
+	ProfileTrack* track = getThreadTrack();
+	event.depth = --track->depth;
+	append(track, event);
+}
+
+ProfileTrack* Profiler::createTrack(const char* name)
+{
+	return registerTrack(name);
+}
+
+void Profiler::record(ProfileTrack* track, const ProfileEvent& event)
+{
+	append(track, event);
+}
+
+std::vector<ProfileReportEntry> Profiler::getFrameReport(unsigned long long frame)
+{
+	std::vector<ProfileReportEntry> report;
+	std::vector<ProfileEvent> events;
+	for (ProfileTrack* track = s_Tracks.load(std::memory_order_acquire); track; track = track->next) {
+		snapshot(track, events);
+
+		// entries of this track start here; a frame has a handful of distinct scopes, linear search is fine
+		size_t trackStart = report.size();
+		for (const ProfileEvent& event : events) {
+			if (event.frame != frame)
+				continue;
+
+			ProfileReportEntry* entry = nullptr;
+			for (size_t i = trackStart; i < report.size() && !entry; i++)
+				if (report[i].depth == event.depth && strcmp(report[i].name, event.name) == 0)
+					entry = &report[i];
+			if (!entry) {
+				report.push_back({ track->name, event.name, event.depth, 0, 0.0 });
+				entry = &report.back();
+			}
+			entry->calls++;
+			entry->milliseconds += (event.end - event.begin) / 1000000.0;
+		}
+	}
+	return report;
+}
+
+void Profiler::printFrameReport(unsigned long long frame)
+{
+	LOG_INFO("Frame %llu profile:", frame);
+	for (const ProfileReportEntry& entry : getFrameReport(frame)) {
+		char line[160];
+		snprintf(line, sizeof(line), "  %-8s %*s%-*s %5u x %9.3f ms", entry.track.c_str(),
+			entry.depth * 2, "", 40 - entry.depth * 2, entry.name, entry.calls, entry.milliseconds);
+		LOG_INFO("%s", line);
+	}
+}
+
+bool Profiler::exportChromeTrace(const std::string& filepath, unsigned int frames)
+{
+	FILE* file = fopen(filepath.c_str(), "w");
+	if (!file) {
+		LOG_ERROR("Failed to open '%s' for the profile trace", filepath.c_str());
+		return false;
+	}
+
+	// events issued before the first exported frame are left out
+	unsigned long long frameCount = s_FrameCount.load(std::memory_order_acquire);
+	unsigned long long firstFrame = 0;
+	if (frames > 0 && frameCount > 0) {
+		unsigned long long count = std::min<unsigned long long>(std::min<unsigned long long>(frames, frameCount), MaxFrames);
+		firstFrame = frameCount - count;
+	}
+	else if (frameCount > MaxFrames) {
+		firstFrame = frameCount - MaxFrames;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"gl3FwEw\"}}");
+
+	for (unsigned long long frame = firstFrame; frame < frameCount; frame++) {
+		fprintf(file, ",\n{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+			frame, s_FrameStarts[frame % MaxFrames] / 1000.0);
+	}
+
+	std::vector<ProfileEvent> events;
+	for (ProfileTrack* track = s_Tracks.load(std::memory_order_acquire); track; track = track->next) {
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", track->id);
+		writeEscaped(file, track->name);
+		fprintf(file, "}}");
+
+		snapshot(track, events);
+		for (const ProfileEvent& event : events) {
+			if (event.frame < firstFrame)
+				continue;
+			fprintf(file, ",\n{\"name\":");
+			writeEscaped(file, event.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu,\"depth\":%u}}",
+				track->id, event.begin / 1000.0, (event.end - event.begin) / 1000.0, event.frame, event.depth);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	bool ok = !ferror(file);
+	fclose(file);
+	if (!ok)
+		LOG_ERROR("Failed to write the profile trace to '%s'", filepath.c_str());
+	return ok;
+}
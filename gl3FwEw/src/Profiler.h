@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Compile-time switch: build with PROFILING=0 and PROFILE_SCOPE / PROFILE_FUNCTION
+// compile to nothing. With it on, a disabled profiler costs one relaxed load per scope.
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+struct ProfileEvent {
+	const char* name;			// must outlive the profiler, i.e. a string literal
+	unsigned long long begin;	// ns since the profiler epoch
+	unsigned long long end;
+	unsigned int depth;			// nesting level on its thread, 0 = outermost
+	unsigned long long frame;	// frame the work was issued in
+};
+
+// Time spent in one scope during one frame, summed over its calls.
+struct ProfileReportEntry {
+	std::string track;			// thread or track name
+	const char* name;
+	unsigned int depth;
+	unsigned int calls;
+	double milliseconds;
+};
+
+// An event stream that isn't a thread, e.g. the GPU timeline. Written by one thread at a time.
+struct ProfileTrack;
+
+// Hierarchical CPU profiler. Every thread records into its own ring of events, so
+// recording never locks; the rings are only read when exporting. Frames are delimited
+// by markFrame() on the render thread, the export covers the last N of them.
+class Profiler
+{
+public:
+	static const unsigned int EventsPerThread = 1 << 16;
+	static const unsigned int MaxFrames = 1024;
+
+	static void setEnabled(bool enabled);
+	static inline bool isEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+	// names the calling thread in the trace
+	static void setThreadName(const char* name);
+
+	// call once per frame, at the start of it
+	static void markFrame();
+	// index of the frame in progress, counting from 0
+	static unsigned long long getFrameIndex();
+
+	// ns since the profiler epoch (process start)
+	static unsigned long long now();
+
+	// used by ProfileScope: enterScope returns the begin timestamp, leaveScope records the event
+	static unsigned long long enterScope();
+	static void leaveScope(const char* name, unsigned long long begin);
+
+	// tracks live as long as the process, like the per-thread rings
+	static ProfileTrack* createTrack(const char* name);
+	static void record(ProfileTrack* track, const ProfileEvent& event);
+
+	// sums every buffered event issued in `frame`, per track and scope, in first-seen order.
+	// Scans all rings, so it's meant for the occasional report, not for every frame.
+	static std::vector<ProfileReportEntry> getFrameReport(unsigned long long frame);
+	static void printFrameReport(unsigned long long frame);
+
+	// writes the last `frames` frames (0 = everything still buffered) as Chrome trace
+	// JSON, loadable in chrome://tracing or ui.perfetto.dev; returns false if the file can't be written
+	static bool exportChromeTrace(const std::string& filepath, unsigned int frames = 0);
+
+private:
+	static std::atomic<bool> s_Enabled;
+};
+
+// Times the enclosing scope.
+class ProfileScope
+{
+private:
+	const char* m_Name;
+	unsigned long long m_Begin;
+
+public:
+	inline ProfileScope(const char* name)
+		: m_Name(Profiler::isEnabled() ? name : nullptr), m_Begin(0)
+	{
+		if (m_Name)
+			m_Begin = Profiler::enterScope();
+	}
+
+	inline ~ProfileScope()
+	{
+		if (m_Name)
+			Profiler::leaveScope(m_Name, m_Begin);
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#if PROFILING
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
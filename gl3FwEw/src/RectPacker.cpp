@@ -0,0 +1,122 @@
+#include "RectPacker.h"
+
+namespace {
+
+	inline bool contains(const PackedRect& outer, const PackedRect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y &&
+			inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+	}
+
+	inline bool intersects(const PackedRect& a, const PackedRect& b)
+	{
+		return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+	}
+
+}
+
+RectPacker::RectPacker(unsigned int width, unsigned int height)
+	: m_Width(width), m_Height(height), m_UsedArea(0)
+{
+	reset();
+}
+
+bool RectPacker::insert(unsigned int width, unsigned int height, PackedRect& rect)
+{
+	if (width == 0 || height == 0)
+		return false;
+
+	// best short side fit: the free rect the new one fills most snugly on one side
+	size_t best = m_FreeRects.size();
+	unsigned int bestShort = ~0u, bestLong = ~0u;
+	for (size_t i = 0; i < m_FreeRects.size(); i++) {
+		const PackedRect& area = m_FreeRects[i];
+		if (area.width < width || area.height < height)
+			continue;
+		unsigned int leftoverX = area.width - width, leftoverY = area.height - height;
+		unsigned int shortSide = leftoverX < leftoverY ? leftoverX : leftoverY;
+		unsigned int longSide = leftoverX < leftoverY ? leftoverY : leftoverX;
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+			best = i;
+			bestShort = shortSide;
+			bestLong = longSide;
+		}
+	}
+	if (best == m_FreeRects.size())
+		return false;
+
+	rect = { m_FreeRects[best].x, m_FreeRects[best].y, width, height };
+	splitFreeRects(rect);
+	pruneFreeRects();
+	m_UsedArea += (unsigned long long)width * height;
+	return true;
+}
+
+void RectPacker::free(const PackedRect& rect)
+{
+	m_UsedArea -= (unsigned long long)rect.width * rect.height;
+	if (m_UsedArea == 0) {
+		reset();
+		return;
+	}
+	m_FreeRects.push_back(rect);
+	pruneFreeRects();
+}
+
+void RectPacker::reset()
+{
+	m_FreeRects.clear();
+	m_FreeRects.push_back({ 0, 0, m_Width, m_Height });
+	m_UsedArea = 0;
+}
+
+float RectPacker::getOccupancy() const
+{
+	return (float)((double)m_UsedArea / ((double)m_Width * m_Height));
+}
+
+void RectPacker::splitFreeRects(const PackedRect& used)
+{
+	// every free rect the new one overlaps is replaced by up to four maximal rects around it
+	m_Split.clear();
+	for (size_t i = 0; i < m_FreeRects.size();) {
+		const PackedRect area = m_FreeRects[i];
+		if (!intersects(area, used)) {
+			i++;
+			continue;
+		}
+		if (used.x > area.x)
+			m_Split.push_back({ area.x, area.y, used.x - area.x, area.height });
+		if (used.x + used.width < area.x + area.width)
+			m_Split.push_back({ used.x + used.width, area.y, area.x + area.width - used.x - used.width, area.height });
+		if (used.y > area.y)
+			m_Split.push_back({ area.x, area.y, area.width, used.y - area.y });
+		if (used.y + used.height < area.y + area.height)
+			m_Split.push_back({ area.x, used.y + used.height, area.width, area.y + area.height - used.y - used.height });
+
+		m_FreeRects[i] = m_FreeRects.back();
+		m_FreeRects.pop_back();
+	}
+	m_FreeRects.insert(m_FreeRects.end(), m_Split.begin(), m_Split.end());
+}
+
+void RectPacker::pruneFreeRects()
+{
+	// drop free rects inside another one, they add nothing
+	for (size_t i = 0; i < m_FreeRects.size(); i++) {
+		for (size_t j = i + 1; j < m_FreeRects.size();) {
+			if (contains(m_FreeRects[i], m_FreeRects[j])) {
+				m_FreeRects[j] = m_FreeRects.back();
+				m_FreeRects.pop_back();
+			}
+			else if (contains(m_FreeRects[j], m_FreeRects[i])) {
+				m_FreeRects[i] = m_FreeRects[j];
+				m_FreeRects[j] = m_FreeRects.back();
+				m_FreeRects.pop_back();
+				j = i + 1;
+			}
+			else
+				j++;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct PackedRect {
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+};
+
+// MaxRects bin packer (best short side fit): keeps the list of maximal free rectangles,
+// so an insert may use any of the overlapping free areas. Supports freeing: the freed
+// rectangle goes back into the free list as is, which doesn't recover every maximal
+// rectangle it touches, so heavy churn fragments the bin until it empties and resets.
+class RectPacker
+{
+private:
+	unsigned int m_Width;
+	unsigned int m_Height;
+	std::vector<PackedRect> m_FreeRects;
+	std::vector<PackedRect> m_Split;		// scratch for insert()
+	unsigned long long m_UsedArea;
+
+public:
+	RectPacker(unsigned int width, unsigned int height);
+
+	// false if it doesn't fit anywhere
+	bool insert(unsigned int width, unsigned int height, PackedRect& rect);
+	// rect has to be one insert() returned
+	void free(const PackedRect& rect);
+	void reset();
+
+	inline unsigned int getWidth() const { return m_Width; }
+	inline unsigned int getHeight() const { return m_Height; }
+	inline unsigned long long getUsedArea() const { return m_UsedArea; }
+	// used area / total area
+	float getOccupancy() const;
+
+private:
+	void splitFreeRects(const PackedRect& used);
+	void pruneFreeRects();
+};
@@ -0,0 +1,196 @@
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <algorithm>
+
+RenderGraph::RenderGraph(RenderTargetPool& pool)
+	: m_Pool(pool), m_Aliasing(true), m_CulledCount(0)
+{
+}
+
+RenderGraph::Resource RenderGraph::createTarget(const char* name, const FramebufferSpec& spec)
+{
+	Target target = { name, spec, false, nullptr, 0 };
+	m_Targets.push_back(target);
+	return (Resource)m_Targets.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::importTarget(const char* name, Framebuffer* framebuffer)
+{
+	Target target = { name, framebuffer->getSpec(), true, framebuffer, 0 };
+	m_Targets.push_back(target);
+	return (Resource)m_Targets.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::importWindow(unsigned int width, unsigned int height)
+{
+	Target target = { "window", { width, height, TextureFormat::RGBA8, 1, true, 1 }, true, nullptr, 0 };
+	m_Targets.push_back(target);
+	return (Resource)m_Targets.size() - 1;
+}
+
+unsigned int RenderGraph::addPass(const char* name, const Execute& execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.culled = false;
+	m_Passes.push_back(std::move(pass));
+	return (unsigned int)m_Passes.size() - 1;
+}
+
+void RenderGraph::read(unsigned int pass, Resource resource)
+{
+	m_Passes[pass].reads.push_back(resource);
+}
+
+void RenderGraph::write(unsigned int pass, Resource resource)
+{
+	m_Passes[pass].writes.push_back(resource);
+}
+
+void RenderGraph::execute()
+{
+	PROFILE_SCOPE("RenderGraph::execute");
+	cull();
+	computeLastUses();
+	m_Physical.clear();
+
+	// passes bind what they draw to; once a target goes back to the pool nothing may stay
+	// bound to it, so the caller's framebuffer comes back after that and at the end
+	GLint entryFramebuffer, entryViewport[4];
+	GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &entryFramebuffer));
+	GLCall(glGetIntegerv(GL_VIEWPORT, entryViewport));
+	auto restoreBinding = [&]() {
+		GLCall(glBindFramebuffer(GL_FRAMEBUFFER, entryFramebuffer));
+		GLCall(glViewport(entryViewport[0], entryViewport[1], entryViewport[2], entryViewport[3]));
+	};
+
+	for (unsigned int i = 0; i < m_Passes.size(); i++) {
+		Pass& pass = m_Passes[i];
+		if (pass.culled)
+			continue;
+
+		bool allocated = true;
+		for (const std::vector<Resource>* resources : { &pass.writes, &pass.reads }) {
+			for (Resource resource : *resources) {
+				Target& target = m_Targets[resource];
+				if (target.imported || target.framebuffer)
+					continue;
+				target.framebuffer = m_Pool.acquire(target.spec);
+				if (!target.framebuffer) {
+					LOG_ERROR("RenderGraph: no framebuffer for %s, skipping %s", target.name, pass.name);
+					allocated = false;
+				}
+				else if (std::find(m_Physical.begin(), m_Physical.end(), target.framebuffer) == m_Physical.end()) {
+					m_Physical.push_back(target.framebuffer);
+				}
+			}
+		}
+		if (allocated) {
+			PROFILE_SCOPE(pass.name);
+			pass.execute(*this);
+		}
+
+		if (!m_Aliasing)
+			continue;
+		// the last use: nobody reads the contents any more, hand the framebuffer to later targets
+		bool released = false;
+		for (const std::vector<Resource>* resources : { &pass.writes, &pass.reads }) {
+			for (Resource resource : *resources) {
+				Target& target = m_Targets[resource];
+				if (target.imported || target.lastPass != i || !target.framebuffer)
+					continue;
+				target.framebuffer->invalidate(true, true);
+				m_Pool.release(target.framebuffer);
+				target.framebuffer = nullptr;
+				released = true;
+			}
+		}
+		if (released)
+			restoreBinding();
+	}
+
+	// without aliasing everything is returned at the end
+	for (Target& target : m_Targets) {
+		if (!target.imported && target.framebuffer) {
+			target.framebuffer->invalidate(true, true);
+			m_Pool.release(target.framebuffer);
+			target.framebuffer = nullptr;
+		}
+	}
+	restoreBinding();
+}
+
+void RenderGraph::reset()
+{
+	m_Targets.clear();
+	m_Passes.clear();
+	m_CulledCount = 0;
+}
+
+Framebuffer* RenderGraph::getFramebuffer(Resource resource) const
+{
+	return m_Targets[resource].framebuffer;
+}
+
+const Texture2D* RenderGraph::getTexture(Resource resource, unsigned int index) const
+{
+	const Framebuffer* framebuffer = m_Targets[resource].framebuffer;
+	return framebuffer ? framebuffer->getColorTexture(index) : nullptr;
+}
+
+void RenderGraph::bind(Resource resource) const
+{
+	const Target& target = m_Targets[resource];
+	if (target.framebuffer)
+		target.framebuffer->bind();
+	else
+		Framebuffer::bindDefault(target.spec.width, target.spec.height);
+}
+
+unsigned long long RenderGraph::getPhysicalBytes() const
+{
+	unsigned long long bytes = 0;
+	for (const Framebuffer* framebuffer : m_Physical)
+		bytes += framebuffer->getByteSize();
+	return bytes;
+}
+
+void RenderGraph::cull()
+{
+	// backwards: a pass is needed if it writes something a needed pass after it reads
+	std::vector<bool> needed(m_Targets.size(), false);
+	m_CulledCount = 0;
+	for (unsigned int i = (unsigned int)m_Passes.size(); i-- > 0;) {
+		Pass& pass = m_Passes[i];
+		pass.culled = true;
+		for (Resource resource : pass.writes) {
+			if (m_Targets[resource].imported || needed[resource])
+				pass.culled = false;
+		}
+		if (pass.culled) {
+			LOG_DEBUG("RenderGraph: culled %s", pass.name);
+			m_CulledCount++;
+			continue;
+		}
+		for (Resource resource : pass.reads)
+			needed[resource] = true;
+	}
+}
+
+void RenderGraph::computeLastUses()
+{
+	for (Target& target : m_Targets)
+		target.lastPass = 0;
+	for (unsigned int i = 0; i < m_Passes.size(); i++) {
+		const Pass& pass = m_Passes[i];
+		if (pass.culled)
+			continue;
+		for (const std::vector<Resource>* resources : { &pass.writes, &pass.reads }) {
+			for (Resource resource : *resources)
+				m_Targets[resource].lastPass = i;
+		}
+	}
+}
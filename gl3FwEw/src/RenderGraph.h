@@ -0,0 +1,85 @@
+#pragma once
+
+#include "RenderTargetPool.h"
+#include <functional>
+#include <vector>
+
+// A frame described as passes over virtual render targets. Passes are added in execution
+// order and declare which targets they read and write; execute() then
+//  - culls passes nothing needs: a pass survives only if it writes an imported target
+//    (the window, a framebuffer owned elsewhere) or a target a surviving pass reads later,
+//  - gives each transient target a framebuffer from the pool right before its first
+//    surviving pass and returns it (invalidated) right after its last one, so targets whose
+//    lifetimes don't overlap alias the same framebuffer when their specs match.
+// A pass without writes is always culled. The graph keeps no GL objects of its own;
+// reset() and describe the next frame again. Names have to be string literals.
+class RenderGraph
+{
+public:
+	typedef unsigned int Resource;
+	typedef std::function<void(const RenderGraph& graph)> Execute;
+
+	static const Resource InvalidResource = ~0u;
+
+private:
+	struct Target {
+		const char* name;
+		FramebufferSpec spec;
+		bool imported;
+		Framebuffer* framebuffer;		// imported, or the pool's while alive; nullptr = window
+		unsigned int lastPass;			// last surviving pass using it, the first one allocates
+	};
+
+	struct Pass {
+		const char* name;				// string literal, it names the profiler scope too
+		Execute execute;
+		std::vector<Resource> reads;
+		std::vector<Resource> writes;
+		bool culled;
+	};
+
+	RenderTargetPool& m_Pool;
+	std::vector<Target> m_Targets;
+	std::vector<Pass> m_Passes;
+	bool m_Aliasing;
+	unsigned int m_CulledCount;
+	std::vector<Framebuffer*> m_Physical;	// distinct pool framebuffers of the last execute()
+
+public:
+	RenderGraph(RenderTargetPool& pool);
+
+	// a target the graph allocates; its contents don't outlive the frame
+	Resource createTarget(const char* name, const FramebufferSpec& spec);
+	// a target owned elsewhere, written passes are never culled
+	Resource importTarget(const char* name, Framebuffer* framebuffer);
+	Resource importWindow(unsigned int width, unsigned int height);
+
+	unsigned int addPass(const char* name, const Execute& execute);
+	void read(unsigned int pass, Resource resource);
+	void write(unsigned int pass, Resource resource);
+
+	// culls, allocates and runs the passes in the order they were added; the framebuffer
+	// and viewport bound on entry are bound again afterwards
+	void execute();
+	// forgets passes and targets, for the next frame
+	void reset();
+
+	// for passes, while they run: nullptr for the window
+	Framebuffer* getFramebuffer(Resource resource) const;
+	// color attachment of a single sampled target, to sample what an earlier pass wrote
+	const Texture2D* getTexture(Resource resource, unsigned int index = 0) const;
+	void bind(Resource resource) const;
+
+	// off: every transient target gets its own framebuffer, to compare against
+	inline void setAliasing(bool aliasing) { m_Aliasing = aliasing; }
+	inline bool isCulled(unsigned int pass) const { return m_Passes[pass].culled; }
+	inline unsigned int getPassCount() const { return (unsigned int)m_Passes.size(); }
+	inline unsigned int getCulledCount() const { return m_CulledCount; }
+	// framebuffers the transient targets of the last execute() used, and their memory
+	inline unsigned int getPhysicalCount() const { return (unsigned int)m_Physical.size(); }
+	unsigned long long getPhysicalBytes() const;
+
+private:
+	void cull();
+	void computeLastUses();
+};
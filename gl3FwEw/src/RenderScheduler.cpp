@@ -0,0 +1,131 @@
+#include "RenderScheduler.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+static inline void invalidateWindow(GLFWwindow* window)
+{
+	RenderScheduler* scheduler = (RenderScheduler*)glfwGetWindowUserPointer(window);
+	if (scheduler)
+		scheduler->invalidate();
+}
+
+RenderScheduler::RenderScheduler(GLFWwindow* window, bool onDemand)
+	: m_Window(window), m_OnDemand(onDemand), m_Dirty(true), m_TimerDeadline(-1.0)
+{
+	glfwSetWindowUserPointer(window, this);
+
+	// anything that can change what's on screen damages the window
+	glfwSetWindowRefreshCallback(window, onWindowRefresh);
+	glfwSetFramebufferSizeCallback(window, onFramebufferSize);
+	glfwSetWindowFocusCallback(window, onWindowFocus);
+	glfwSetKeyCallback(window, onKey);
+	glfwSetCharCallback(window, onChar);
+	glfwSetCursorPosCallback(window, onCursorPos);
+	glfwSetMouseButtonCallback(window, onMouseButton);
+	glfwSetScrollCallback(window, onScroll);
+}
+
+RenderScheduler::~RenderScheduler()
+{
+	glfwSetWindowRefreshCallback(m_Window, nullptr);
+	glfwSetFramebufferSizeCallback(m_Window, nullptr);
+	glfwSetWindowFocusCallback(m_Window, nullptr);
+	glfwSetKeyCallback(m_Window, nullptr);
+	glfwSetCharCallback(m_Window, nullptr);
+	glfwSetCursorPosCallback(m_Window, nullptr);
+	glfwSetMouseButtonCallback(m_Window, nullptr);
+	glfwSetScrollCallback(m_Window, nullptr);
+	glfwSetWindowUserPointer(m_Window, nullptr);
+}
+
+void RenderScheduler::invalidate()
+{
+	// only wake the loop on the clean -> dirty transition
+	if (!m_Dirty.exchange(true))
+		glfwPostEmptyEvent();
+}
+
+void RenderScheduler::invalidateAfter(double seconds)
+{
+	double deadline = glfwGetTime() + seconds;
+	if (m_TimerDeadline < 0.0 || deadline < m_TimerDeadline)
+		m_TimerDeadline = deadline;
+}
+
+bool RenderScheduler::waitForFrame()
+{
+	if (!m_OnDemand) {
+		/* Poll for and process events */
+		glfwPollEvents();
+		m_Dirty = false;
+		return !glfwWindowShouldClose(m_Window);
+	}
+
+	while (!glfwWindowShouldClose(m_Window)) {
+		if (m_TimerDeadline >= 0.0 && glfwGetTime() >= m_TimerDeadline) {
+			m_TimerDeadline = -1.0;
+			m_Dirty = true;
+		}
+
+		if (m_Dirty.exchange(false)) {
+			// drain whatever else queued up so it's part of this frame
+			glfwPollEvents();
+			m_Dirty = false;
+			return !glfwWindowShouldClose(m_Window);
+		}
+
+		/* Sleep until something happens */
+		if (m_TimerDeadline >= 0.0) {
+			// the deadline may pass between the check above and here, GLFW rejects negative timeouts
+			double timeout = m_TimerDeadline - glfwGetTime();
+			if (timeout > 0.0)
+				glfwWaitEventsTimeout(timeout);
+			else
+				glfwPollEvents();
+		}
+		else
+			glfwWaitEvents();
+	}
+	return false;
+}
+
+void RenderScheduler::onWindowRefresh(GLFWwindow* window)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onFramebufferSize(GLFWwindow* window, int width, int height)
+{
+	glViewport(0, 0, width, height);
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onWindowFocus(GLFWwindow* window, int)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onKey(GLFWwindow* window, int, int, int, int)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onChar(GLFWwindow* window, unsigned int)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onCursorPos(GLFWwindow* window, double, double)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onMouseButton(GLFWwindow* window, int, int, int)
+{
+	invalidateWindow(window);
+}
+
+void RenderScheduler::onScroll(GLFWwindow* window, double, double)
+{
+	invalidateWindow(window);
+}
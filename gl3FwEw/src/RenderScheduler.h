@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+
+struct GLFWwindow;
+
+// Decides when the main loop renders a frame.
+// Continuous mode polls events and renders every iteration (the classic game loop).
+// On-demand mode blocks in glfwWaitEvents(Timeout) until something damaged the window:
+// input, a resize/refresh, an expired timer or an explicit invalidate().
+class RenderScheduler
+{
+private:
+	GLFWwindow* m_Window;
+	bool m_OnDemand;
+	std::atomic<bool> m_Dirty;
+	double m_TimerDeadline;		// glfwGetTime() seconds, negative = no timer pending
+
+	static void onWindowRefresh(GLFWwindow* window);
+	static void onFramebufferSize(GLFWwindow* window, int width, int height);
+	static void onWindowFocus(GLFWwindow* window, int focused);
+	static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void onChar(GLFWwindow* window, unsigned int codepoint);
+	static void onCursorPos(GLFWwindow* window, double x, double y);
+	static void onMouseButton(GLFWwindow* window, int button, int action, int mods);
+	static void onScroll(GLFWwindow* window, double x, double y);
+
+public:
+	// installs the window's input callbacks and sets its user pointer
+	RenderScheduler(GLFWwindow* window, bool onDemand = false);
+	~RenderScheduler();
+
+	inline void setOnDemand(bool onDemand) { m_OnDemand = onDemand; invalidate(); }
+	inline bool isOnDemand() const { return m_OnDemand; }
+
+	// request a redraw; safe to call from any thread
+	void invalidate();
+	// request a redraw in `seconds` from now (GL thread only); the earliest pending timer wins
+	void invalidateAfter(double seconds);
+
+	// handles events and returns when a frame should be rendered,
+	// false once the window was asked to close
+	bool waitForFrame();
+};
@@ -0,0 +1,71 @@
+#include "RenderTargetPool.h"
+#include "Profiler.h"
+#include "Log.h"
+
+RenderTargetPool::RenderTargetPool(unsigned int maxIdleFrames)
+	: m_MaxIdleFrames(maxIdleFrames), m_Frame(0), m_Allocations(0)
+{
+}
+
+Framebuffer* RenderTargetPool::acquire(const FramebufferSpec& requested)
+{
+	// compared against what the framebuffers report, e.g. samples 0 is 1 there
+	FramebufferSpec spec = requested.normalized();
+	for (Slot& slot : m_Slots) {
+		if (!slot.inUse && slot.framebuffer->getSpec() == spec) {
+			slot.inUse = true;
+			slot.lastUsedFrame = m_Frame;
+			return slot.framebuffer.get();
+		}
+	}
+
+	PROFILE_SCOPE("RenderTargetPool::create");
+	Slot slot;
+	slot.framebuffer.reset(new Framebuffer(spec));
+	if (!slot.framebuffer->isComplete())
+		return nullptr;
+	slot.lastUsedFrame = m_Frame;
+	slot.inUse = true;
+	m_Allocations++;
+	m_Slots.push_back(std::move(slot));
+	return m_Slots.back().framebuffer.get();
+}
+
+void RenderTargetPool::release(Framebuffer* framebuffer)
+{
+	for (Slot& slot : m_Slots) {
+		if (slot.framebuffer.get() == framebuffer) {
+			slot.inUse = false;
+			return;
+		}
+	}
+	LOG_WARN("RenderTargetPool: release of a framebuffer the pool doesn't own");
+}
+
+void RenderTargetPool::endFrame()
+{
+	for (size_t i = 0; i < m_Slots.size();) {
+		const Slot& slot = m_Slots[i];
+		if (!slot.inUse && m_Frame - slot.lastUsedFrame >= m_MaxIdleFrames) {
+			m_Slots[i] = std::move(m_Slots.back());
+			m_Slots.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+	m_Frame++;
+}
+
+void RenderTargetPool::clear()
+{
+	m_Slots.clear();
+}
+
+unsigned long long RenderTargetPool::getByteSize() const
+{
+	unsigned long long bytes = 0;
+	for (const Slot& slot : m_Slots)
+		bytes += slot.framebuffer->getByteSize();
+	return bytes;
+}
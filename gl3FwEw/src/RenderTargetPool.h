@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Framebuffer.h"
+#include <memory>
+#include <vector>
+
+// Transient render targets recycled across frames. acquire() hands out a free framebuffer
+// with exactly the requested spec (size, format, attachments, samples) or creates one;
+// release() returns it for the next acquire of the same spec, this frame or a later one.
+// endFrame() deletes targets nobody acquired for maxIdleFrames, so a window resize or an
+// effect switched off frees its targets without churning ones that are only used every
+// few frames.
+class RenderTargetPool
+{
+public:
+	static const unsigned int DefaultMaxIdleFrames = 60;
+
+private:
+	struct Slot {
+		std::unique_ptr<Framebuffer> framebuffer;
+		unsigned long long lastUsedFrame;
+		bool inUse;
+	};
+
+	std::vector<Slot> m_Slots;
+	unsigned int m_MaxIdleFrames;
+	unsigned long long m_Frame;
+	unsigned long long m_Allocations;
+
+public:
+	RenderTargetPool(unsigned int maxIdleFrames = DefaultMaxIdleFrames);
+
+	// nullptr if GL can't create the combination (the reason was logged)
+	Framebuffer* acquire(const FramebufferSpec& spec);
+	void release(Framebuffer* framebuffer);
+	// once per frame, after everything acquired in it was released
+	void endFrame();
+	// deletes all targets, including ones in use; needs the context to be current
+	void clear();
+
+	inline unsigned int getCount() const { return (unsigned int)m_Slots.size(); }
+	// framebuffers created over the pool's lifetime, flat when frames reuse them
+	inline unsigned long long getAllocations() const { return m_Allocations; }
+	unsigned long long getByteSize() const;
+};
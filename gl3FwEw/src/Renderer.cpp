@@ -1,5 +1,10 @@
 #include "Renderer.h"
-#include <iostream>
+#include "VertexArray.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "FrameCapture.h"
+#include "Log.h"
+#include <cstdio>
 
 
 void GLClearError()
@@ -11,9 +16,127 @@ bool GLLogCall(const char* function, const char* file, int line)
 {
 	while (GLenum error = glGetError())
 	{
-		std::cout << "[OpenGL Error] (" << error << "): " << function <<
-			" " << file << ":" << line << std::endl;
+		LOG_ERROR("[OpenGL Error] (%u): %s %s:%d", error, function, file, line);
+		GLTracer::recordError(error);
 		return false;
 	}
 	return true;
 }
+
+void RenderStats::reset()
+{
+	drawCalls = 0;
+	vertexArrayBinds = 0;
+	vertexBufferBinds = 0;
+	indexBufferBinds = 0;
+	shaderBinds = 0;
+	textureBinds = 0;
+	samplerBinds = 0;
+	uniformUpdates = 0;
+	bytesUploaded = 0;
+	triangles = 0;
+}
+
+RenderStats Renderer::s_Counters = {};
+
+Renderer::Renderer()
+	: m_FrameStats(), m_HistoryCount(0)
+{
+}
+
+void Renderer::clear() const
+{
+	GLCall(glClear(GL_COLOR_BUFFER_BIT));
+	if (FrameCapture::isCapturing())
+		FrameCapture::onClear(GL_COLOR_BUFFER_BIT);
+}
+
+void Renderer::draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
+{
+	shader.bind();
+	draw(va, ib);
+}
+
+void Renderer::draw(const VertexArray& va, const IndexBuffer& ib) const
+{
+	draw(va, ib, ib.getCount());
+}
+
+void Renderer::draw(const VertexArray& va, const IndexBuffer& ib, unsigned int count) const
+{
+	ASSERT(count <= ib.getCount());
+	va.bind();
+	ib.bind();
+	GLCall(glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr));
+
+	s_Counters.drawCalls++;
+	s_Counters.triangles += count / 3;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+}
+
+void Renderer::drawInstancedQuads(const VertexArray& va, unsigned int instances) const
+{
+	va.bind();
+	GLCall(glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances));
+
+	s_Counters.drawCalls++;
+	s_Counters.triangles += instances * 2ull;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances);
+}
+
+void Renderer::endFrame()
+{
+	m_FrameStats = s_Counters;
+	m_History[m_HistoryCount % StatsHistory] = s_Counters;
+	m_HistoryCount++;
+	s_Counters.reset();
+
+	FrameCapture::endFrame();
+}
+
+RenderStatsAverage Renderer::getAverageStats() const
+{
+	RenderStatsAverage average = {};
+	average.frames = m_HistoryCount < StatsHistory ? m_HistoryCount : StatsHistory;
+	if (average.frames == 0)
+		return average;
+
+	for (unsigned int i = 0; i < average.frames; i++) {
+		const RenderStats& stats = m_History[i];
+		average.drawCalls += stats.drawCalls;
+		average.vertexArrayBinds += stats.vertexArrayBinds;
+		average.vertexBufferBinds += stats.vertexBufferBinds;
+		average.indexBufferBinds += stats.indexBufferBinds;
+		average.shaderBinds += stats.shaderBinds;
+		average.textureBinds += stats.textureBinds;
+		average.samplerBinds += stats.samplerBinds;
+		average.uniformUpdates += stats.uniformUpdates;
+		average.bytesUploaded += stats.bytesUploaded;
+		average.triangles += stats.triangles;
+	}
+
+	double scale = 1.0 / average.frames;
+	average.drawCalls *= scale;
+	average.vertexArrayBinds *= scale;
+	average.vertexBufferBinds *= scale;
+	average.indexBufferBinds *= scale;
+	average.shaderBinds *= scale;
+	average.textureBinds *= scale;
+	average.samplerBinds *= scale;
+	average.uniformUpdates *= scale;
+	average.bytesUploaded *= scale;
+	average.triangles *= scale;
+	return average;
+}
+
+void Renderer::printStats() const
+{
+	RenderStatsAverage average = getAverageStats();
+	char line[320];
+	snprintf(line, sizeof(line), "[Stats] %u frames avg: %.1f draws, %.1f tris, %.1f VAO / %.1f VBO / %.1f IBO / %.1f shader / %.1f texture / %.1f sampler binds, %.1f uniforms, %.0f bytes uploaded",
+		average.frames, average.drawCalls, average.triangles, average.vertexArrayBinds, average.vertexBufferBinds,
+		average.indexBufferBinds, average.shaderBinds, average.textureBinds, average.samplerBinds, average.uniformUpdates, average.bytesUploaded);
+	LOG_INFO("%s", line);
+}
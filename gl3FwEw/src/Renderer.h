@@ -2,11 +2,91 @@
 #include <GL/glew.h>
 
 #include <iostream>
+#include "GLTracer.h"
 
-#define ASSERT(x) if (!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
+#ifdef _MSC_VER
+#define DEBUG_BREAK() __debugbreak()
+#else
+#include <csignal>
+#define DEBUG_BREAK() raise(SIGTRAP)
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
+// the trace and the error clear are one statement, like the plain GLClearError() was
+#define GLCall(x) GLTraceCall(#x), GLClearError();\
 	x;\
 	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
+
+class VertexArray;
+class IndexBuffer;
+class Shader;
+
+// What one frame cost. The wrappers count into Renderer::counters() as they go.
+struct RenderStats {
+	unsigned int drawCalls;
+	unsigned int vertexArrayBinds;
+	unsigned int vertexBufferBinds;
+	unsigned int indexBufferBinds;
+	unsigned int shaderBinds;
+	unsigned int textureBinds;		// only the ones that reached GL, see TextureUnits
+	unsigned int samplerBinds;
+	unsigned int uniformUpdates;
+	unsigned long long bytesUploaded;	// buffer data handed to GL
+	unsigned long long triangles;
+
+	void reset();
+};
+
+// RenderStats averaged over the last few frames.
+struct RenderStatsAverage {
+	double drawCalls;
+	double vertexArrayBinds;
+	double vertexBufferBinds;
+	double indexBufferBinds;
+	double shaderBinds;
+	double textureBinds;
+	double samplerBinds;
+	double uniformUpdates;
+	double bytesUploaded;
+	double triangles;
+	unsigned int frames;		// how many frames went into the average
+};
+
+class Renderer
+{
+public:
+	static const unsigned int StatsHistory = 60;
+
+private:
+	RenderStats m_FrameStats;
+	RenderStats m_History[StatsHistory];
+	unsigned int m_HistoryCount;
+
+	static RenderStats s_Counters;
+
+public:
+	Renderer();
+
+	void clear() const;
+	// binds all three and draws the whole index buffer as triangles
+	void draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	// same, with whatever program is bound already
+	void draw(const VertexArray& va, const IndexBuffer& ib) const;
+	// only the first count indices, e.g. the filled part of a batch
+	void draw(const VertexArray& va, const IndexBuffer& ib, unsigned int count) const;
+	// one 4 vertex triangle strip per instance and no index buffer; the vertex shader
+	// builds the corners from gl_VertexID, e.g. sprites
+	void drawInstancedQuads(const VertexArray& va, unsigned int instances) const;
+
+	// closes the frame: its counters become getFrameStats() and go into the average
+	void endFrame();
+	inline const RenderStats& getFrameStats() const { return m_FrameStats; }
+	RenderStatsAverage getAverageStats() const;
+	void printStats() const;
+
+	// the frame being counted; single threaded like the rest of the GL calls
+	static inline RenderStats& counters() { return s_Counters; }
+};
@@ -0,0 +1,72 @@
+#include "SamplerCache.h"
+#include "Renderer.h"
+#include "TextureUnits.h"
+#include <unordered_map>
+
+namespace {
+
+	std::unordered_map<unsigned int, unsigned int> s_Samplers;	// key -> sampler
+
+	GLint getWrapMode(SamplerWrap wrap)
+	{
+		switch (wrap) {
+			case SamplerWrap::Repeat:			return GL_REPEAT;
+			case SamplerWrap::ClampToEdge:		return GL_CLAMP_TO_EDGE;
+			case SamplerWrap::MirroredRepeat:	return GL_MIRRORED_REPEAT;
+		}
+		return GL_REPEAT;
+	}
+
+}
+
+unsigned int SamplerState::getKey() const
+{
+	return (unsigned int)filter | (unsigned int)wrapU << 8 | (unsigned int)wrapV << 16 | (unsigned int)anisotropy << 24;
+}
+
+unsigned int SamplerCache::get(const SamplerState& state)
+{
+	unsigned int key = state.getKey();
+	auto cached = s_Samplers.find(key);
+	if (cached != s_Samplers.end())
+		return cached->second;
+
+	GLint minFilter = GL_NEAREST, magFilter = GL_NEAREST;
+	switch (state.filter) {
+		case SamplerFilter::Nearest:		minFilter = GL_NEAREST; magFilter = GL_NEAREST; break;
+		case SamplerFilter::Linear:			minFilter = GL_LINEAR; magFilter = GL_LINEAR; break;
+		case SamplerFilter::NearestMipmap:	minFilter = GL_NEAREST_MIPMAP_NEAREST; magFilter = GL_NEAREST; break;
+		case SamplerFilter::Bilinear:		minFilter = GL_LINEAR_MIPMAP_NEAREST; magFilter = GL_LINEAR; break;
+		case SamplerFilter::Trilinear:		minFilter = GL_LINEAR_MIPMAP_LINEAR; magFilter = GL_LINEAR; break;
+	}
+
+	unsigned int sampler = 0;
+	GLCall(glGenSamplers(1, &sampler));
+	GLCall(glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter));
+	GLCall(glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter));
+	GLCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, getWrapMode(state.wrapU)));
+	GLCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, getWrapMode(state.wrapV)));
+	if (state.anisotropy > 1 && GLEW_EXT_texture_filter_anisotropic) {
+		GLfloat maxAnisotropy = 1.0f;
+		GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy));
+		GLfloat anisotropy = state.anisotropy < maxAnisotropy ? (GLfloat)state.anisotropy : maxAnisotropy;
+		GLCall(glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+	}
+
+	s_Samplers[key] = sampler;
+	return sampler;
+}
+
+unsigned int SamplerCache::getCount()
+{
+	return (unsigned int)s_Samplers.size();
+}
+
+void SamplerCache::clear()
+{
+	for (auto& entry : s_Samplers) {
+		TextureUnits::onDeleteSampler(entry.second);
+		GLCall(glDeleteSamplers(1, &entry.second));
+	}
+	s_Samplers.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+enum class SamplerFilter : unsigned char {
+	Nearest,
+	Linear,
+	NearestMipmap,		// nearest texel of the nearest mip
+	Bilinear,			// linear within the nearest mip
+	Trilinear			// linear within and between mips
+};
+
+enum class SamplerWrap : unsigned char {
+	Repeat,
+	ClampToEdge,
+	MirroredRepeat
+};
+
+// Filter and wrap state that would otherwise be texture parameters.
+struct SamplerState {
+	SamplerFilter filter;
+	SamplerWrap wrapU;
+	SamplerWrap wrapV;
+	unsigned char anisotropy;	// 1 = off, clamped to what the driver supports
+
+	static SamplerState nearest(SamplerWrap wrap = SamplerWrap::ClampToEdge) { return { SamplerFilter::Nearest, wrap, wrap, 1 }; }
+	static SamplerState linear(SamplerWrap wrap = SamplerWrap::ClampToEdge) { return { SamplerFilter::Linear, wrap, wrap, 1 }; }
+	static SamplerState trilinear(SamplerWrap wrap = SamplerWrap::Repeat, unsigned char anisotropy = 1) { return { SamplerFilter::Trilinear, wrap, wrap, anisotropy }; }
+
+	// packed into 32 bits, the cache key
+	unsigned int getKey() const;
+};
+
+// One GL sampler object per distinct SamplerState, shared by every texture using that
+// state. Samplers live until clear(), which has to run while the context is still current.
+class SamplerCache
+{
+public:
+	static unsigned int get(const SamplerState& state);
+	static unsigned int getCount();
+	static void clear();
+};
@@ -1,51 +1,94 @@
 #include "Shader.h"
-#include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include "Renderer.h"
+#include "Profiler.h"
+#include "Log.h"
+#include "FrameCapture.h"
 
 Shader::Shader(const std::string & filepath)
 	: m_FilePath(filepath), m_RendererID(0)
 {
+	PROFILE_SCOPE("Shader::Shader");
 	ShaderProgramSources source = parseShader(filepath);
-	std::cout << "VERTEX: " << std::endl;
-	std::cout << source.vertexSource << std::endl;
-	std::cout << "FRAGMENT: " << std::endl;
-	std::cout << source.fragmentSource << std::endl;
+	LOG_DEBUG("VERTEX:\n%s", source.vertexSource.c_str());
+	LOG_DEBUG("FRAGMENT:\n%s", source.fragmentSource.c_str());
 	m_RendererID = createShader(source.vertexSource, source.fragmentSource);
+	FrameCapture::onCreateProgram(m_RendererID, source.vertexSource, source.fragmentSource);
+}
 
+Shader::Shader(const ShaderProgramSources& sources)
+	: m_RendererID(0)
+{
+	PROFILE_SCOPE("Shader::Shader");
+	m_RendererID = createShader(sources.vertexSource, sources.fragmentSource);
+	FrameCapture::onCreateProgram(m_RendererID, sources.vertexSource, sources.fragmentSource);
 }
 
 Shader::~Shader()
 {
+	FrameCapture::onDeleteProgram(m_RendererID);
 	GLCall(glDeleteProgram(m_RendererID));
 
 }
 
 void Shader::bind() const
 {
+	Renderer::counters().shaderBinds++;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onUseProgram(m_RendererID);
 	GLCall(glUseProgram(m_RendererID));
 }
 
 void Shader::unbind() const
 {
+	if (FrameCapture::isCapturing())
+		FrameCapture::onUseProgram(0);
 	GLCall(glUseProgram(0));
 }
 
 void Shader::setUniform4f(const std::string & name, float f0, float f1, float f2, float f3)
 {
 	GLCall(glUniform4f(getUniformLocation(name), f0, f1, f2, f3));
+	Renderer::counters().uniformUpdates++;
+	if (FrameCapture::isCapturing()) {
+		float values[] = { f0, f1, f2, f3 };
+		FrameCapture::onUniform(name, GL_FLOAT_VEC4, values, 4);
+	}
+}
+
+void Shader::setUniform1iv(const std::string& name, const int* values, unsigned int count)
+{
+	GLCall(glUniform1iv(getUniformLocation(name), count, values));
+	Renderer::counters().uniformUpdates++;
+	if (FrameCapture::isCapturing()) {
+		// the capture stores arrays per element, like the snapshot does
+		if (count == 1)
+			FrameCapture::onUniform(name, GL_INT, values, 1);
+		for (unsigned int i = 0; count > 1 && i < count; i++)
+			FrameCapture::onUniform(name + "[" + std::to_string(i) + "]", GL_INT, values + i, 1);
+	}
+}
+
+void Shader::setUniformMat4f(const std::string& name, const float* matrix)
+{
+	GLCall(glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, matrix));
+	Renderer::counters().uniformUpdates++;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onUniform(name, GL_FLOAT_MAT4, matrix, 16);
 }
 
 int Shader::getUniformLocation(const std::string & name)
 {
-	if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-		return m_UniformLocationCache[name];
+	// called for every uniform set, so only one hash lookup on the hit path
+	auto cached = m_UniformLocationCache.find(name);
+	if (cached != m_UniformLocationCache.end())
+		return cached->second;
 	
 	GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
 	if (location == -1)
-		std::cout << "Warning: uniform '" << name << "' doesn't exist!" << std::endl;
+		LOG_WARN("uniform '%s' doesn't exist!", name.c_str());
 	
 	m_UniformLocationCache[name] = location;
 
@@ -57,7 +100,7 @@ ShaderProgramSources Shader::parseShader(const std::string& filepath) {
 	enum class ShaderType {
 		NONE = -1, VERTEX = 0, FRAGMENT = 1
 	};
-	std::cout << filepath << std::endl;
+	LOG_DEBUG("%s", filepath.c_str());
 	std::ifstream stream(filepath);
 	std::string line;
 	std::stringstream ss[2];
@@ -117,9 +160,7 @@ unsigned int Shader::compileShader(unsigned int type, const std::string& source)
 		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
 		char* message = (char*)alloca(length * sizeof(char));
 		glGetShaderInfoLog(id, length, &length, message);
-		std::cout << "Failed to compile " <<
-			(type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
-		std::cout << message << std::endl;
+		LOG_ERROR("Failed to compile %s shader!\n%s", type == GL_VERTEX_SHADER ? "vertex" : "fragment", message);
 		glDeleteShader(id);
 		return 0;
 	}
@@ -16,6 +16,7 @@ private:
 
 public:
 	Shader(const std::string& filepath);
+	Shader(const ShaderProgramSources& sources);	// for generated shaders, no file involved
 	~Shader();
 
 	void bind() const;
@@ -23,10 +24,17 @@ public:
 
 	// Set uniforms
 	void setUniform4f(const std::string& name, float f0, float f1, float f2, float f3);
+	// whole int / sampler array, count elements from [0]
+	void setUniform1iv(const std::string& name, const int* values, unsigned int count);
+	// column-major 4x4
+	void setUniformMat4f(const std::string& name, const float* matrix);
+
+	int getUniformLocation(const std::string& name);
+
+	// splits a "#shader vertex" / "#shader fragment" file into its two sources
+	static ShaderProgramSources parseShader(const std::string& filepath);
 
 private:
 	unsigned int createShader(const std::string& vertexShader, const std::string& fragmentShader);
-	ShaderProgramSources parseShader(const std::string& filepath);
 	unsigned int compileShader(unsigned int type, const std::string& source);
-	int getUniformLocation(const std::string& name);
 };
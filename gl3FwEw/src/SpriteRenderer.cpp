@@ -0,0 +1,117 @@
+#include "SpriteRenderer.h"
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Profiler.h"
+
+static const float s_IdentityMatrix[16] = {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f
+};
+
+SpriteRenderer::SpriteRenderer(const Renderer& renderer, Shader& shader, unsigned int maxSprites)
+	: m_Renderer(renderer), m_Shader(shader), m_MaxSprites(maxSprites > 0 ? maxSprites : 1),
+	m_Count(0), m_Texture(nullptr), m_Stats()
+{
+	static_assert(sizeof(SpriteInstance) == 32, "SpriteInstance must match the sprite shader's attributes");
+	m_Instances.resize(m_MaxSprites);
+
+	VertexBufferLayout layout;
+	layout.push<float>(4);				// rect
+	layout.push<unsigned short>(4);		// texRect
+	layout.push<unsigned char>(4);		// color
+	layout.push<float>(1);				// rotation
+	layout.setDivisor(1);
+
+	m_VertexArray.reset(new VertexArray());
+	m_InstanceBuffer.reset(new VertexBuffer(m_MaxSprites * (unsigned int)sizeof(SpriteInstance)));
+	m_VertexArray->addBuffer(*m_InstanceBuffer, layout);
+
+	unsigned int white = 0xffffffff;
+	m_WhiteTexture.reset(new Texture2D(1, 1, &white));
+	m_WhiteTexture->setSampler(SamplerState::nearest());
+}
+
+// out of line for the unique_ptr<Texture2D>
+SpriteRenderer::~SpriteRenderer()
+{
+}
+
+void SpriteRenderer::begin(const float* viewProjection)
+{
+	m_Stats = SpriteStats();
+	m_Count = 0;
+	m_Texture = nullptr;
+
+	int unit = 0;
+	m_Shader.bind();
+	m_Shader.setUniformMat4f("u_ViewProjection", viewProjection ? viewProjection : s_IdentityMatrix);
+	m_Shader.setUniform1iv("u_Texture", &unit, 1);
+}
+
+void SpriteRenderer::drawSprite(float x, float y, float width, float height, const Texture2D* texture,
+	const float* uv, const float* color, float rotation)
+{
+	setTexture(texture);
+	SpriteInstance& sprite = m_Instances[m_Count++];
+	sprite.rect[0] = x;
+	sprite.rect[1] = y;
+	sprite.rect[2] = width;
+	sprite.rect[3] = height;
+	if (uv) {
+		for (int i = 0; i < 4; i++)
+			sprite.texRect[i] = packTexCoord(uv[i]);
+	}
+	else {
+		sprite.texRect[0] = sprite.texRect[1] = 0;
+		sprite.texRect[2] = sprite.texRect[3] = 65535;
+	}
+	sprite.color = color ? BatchRenderer::packColor(color) : 0xffffffff;
+	sprite.rotation = rotation;
+}
+
+void SpriteRenderer::drawSprite(const SpriteInstance& sprite, const Texture2D* texture)
+{
+	setTexture(texture);
+	m_Instances[m_Count++] = sprite;
+}
+
+void SpriteRenderer::end()
+{
+	flush();
+}
+
+void SpriteRenderer::flush()
+{
+	if (m_Count == 0)
+		return;
+	PROFILE_SCOPE("SpriteRenderer::flush");
+
+	// the previous batch may still be drawing from the buffer
+	m_InstanceBuffer->orphan();
+	m_InstanceBuffer->setData(m_Instances.data(), m_Count * (unsigned int)sizeof(SpriteInstance));
+
+	(m_Texture ? m_Texture : m_WhiteTexture.get())->bind(0);
+	m_Shader.bind();
+	m_Renderer.drawInstancedQuads(*m_VertexArray, m_Count);
+
+	m_Stats.sprites += m_Count;
+	m_Stats.flushes++;
+	m_Count = 0;
+}
+
+unsigned short SpriteRenderer::packTexCoord(float t)
+{
+	t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+	return (unsigned short)(t * 65535.0f + 0.5f);
+}
+
+void SpriteRenderer::setTexture(const Texture2D* texture)
+{
+	if (m_Count > 0 && (texture != m_Texture || m_Count == m_MaxSprites))
+		flush();
+	m_Texture = texture;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+class Renderer;
+class Shader;
+class Texture2D;
+
+// One sprite, 32 bytes: the whole per-sprite cost. res/shaders/sprite.shader reads it as
+// instanced attributes and builds the four corners from gl_VertexID.
+struct SpriteInstance {
+	float rect[4];				// x, y of the lower left corner, width, height
+	unsigned short texRect[4];	// u0, v0, u1, v1 normalized to 0..65535
+	unsigned int color;			// RGBA8, see BatchRenderer::packColor
+	float rotation;				// radians, around the center
+};
+
+struct SpriteStats {
+	unsigned int sprites;
+	unsigned int flushes;		// = draw calls
+};
+
+// Sprites and particles without a vertex or index buffer of corners: every sprite is one
+// SpriteInstance, drawn as a 4 vertex triangle strip instance. Compared to BatchRenderer's
+// 4 x 24 byte vertices plus indices, a sprite uploads a third of the bytes and reads no
+// index buffer. One texture per batch, so sort sprites by texture (or use an atlas); the
+// batch is flushed on a texture change, when maxSprites are queued and at end().
+// A null texture = a 1x1 white texture for solid sprites.
+class SpriteRenderer
+{
+public:
+	static const unsigned int DefaultMaxSprites = 16384;
+
+private:
+	const Renderer& m_Renderer;
+	Shader& m_Shader;
+	unsigned int m_MaxSprites;
+
+	std::unique_ptr<VertexArray> m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_InstanceBuffer;
+	std::vector<SpriteInstance> m_Instances;	// m_MaxSprites, allocated once
+	unsigned int m_Count;
+
+	const Texture2D* m_Texture;		// of the current batch
+	std::unique_ptr<Texture2D> m_WhiteTexture;
+
+	SpriteStats m_Stats;
+
+public:
+	// shader: res/shaders/sprite.shader or a compatible program
+	SpriteRenderer(const Renderer& renderer, Shader& shader, unsigned int maxSprites = DefaultMaxSprites);
+	~SpriteRenderer();
+
+	// viewProjection: column-major 4x4, nullptr = positions are in clip space already
+	void begin(const float* viewProjection = nullptr);
+	// uv = u0, v0, u1, v1 (nullptr = the whole texture), color tints (nullptr = white)
+	void drawSprite(float x, float y, float width, float height, const Texture2D* texture = nullptr,
+		const float* uv = nullptr, const float* color = nullptr, float rotation = 0.0f);
+	// an already built record, e.g. from a particle system
+	void drawSprite(const SpriteInstance& sprite, const Texture2D* texture = nullptr);
+	void end();
+	void flush();
+
+	inline const SpriteStats& getStats() const { return m_Stats; }
+
+	static unsigned short packTexCoord(float t);
+
+private:
+	void setTexture(const Texture2D* texture);
+};
@@ -0,0 +1,265 @@
+#include "Texture.h"
+#include "TextureUnits.h"
+#include "Renderer.h"
+#include "Profiler.h"
+
+namespace {
+
+	struct FormatInfo {
+		GLenum internalFormat;
+		GLenum format;
+		GLenum type;
+		unsigned int bytesPerPixel;
+		unsigned int blockBytes;	// bytes per 4x4 block, 0 = not compressed
+	};
+
+	const FormatInfo& getFormatInfo(TextureFormat format)
+	{
+		static const FormatInfo s_Formats[] = {
+			{ GL_RGBA8,								GL_RGBA,	GL_UNSIGNED_BYTE, 4, 0 },	// RGBA8
+			{ GL_RGB8,								GL_RGB,		GL_UNSIGNED_BYTE, 3, 0 },	// RGB8
+			{ GL_R8,								GL_RED,		GL_UNSIGNED_BYTE, 1, 0 },	// R8
+			{ GL_SRGB8_ALPHA8,						GL_RGBA,	GL_UNSIGNED_BYTE, 4, 0 },	// SRGB8_Alpha8
+			{ GL_RGBA16F,							GL_RGBA,	GL_HALF_FLOAT, 8, 0 },		// RGBA16F
+			{ GL_DEPTH24_STENCIL8,					GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, 0 },	// Depth24Stencil8
+			{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT,		GL_NONE,	GL_NONE, 0, 8 },			// BC1
+			{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,		GL_NONE,	GL_NONE, 0, 8 },			// BC1_Alpha
+			{ GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,		GL_NONE,	GL_NONE, 0, 16 },			// BC2
+			{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,		GL_NONE,	GL_NONE, 0, 16 },			// BC3
+			{ GL_COMPRESSED_RED_RGTC1,				GL_NONE,	GL_NONE, 0, 8 },			// BC4
+			{ GL_COMPRESSED_RG_RGTC2,				GL_NONE,	GL_NONE, 0, 16 },			// BC5
+			{ GL_COMPRESSED_RGBA_BPTC_UNORM,		GL_NONE,	GL_NONE, 0, 16 },			// BC7
+			{ GL_COMPRESSED_RGB8_ETC2,				GL_NONE,	GL_NONE, 0, 8 },			// ETC2_RGB8
+			{ GL_COMPRESSED_RGBA8_ETC2_EAC,			GL_NONE,	GL_NONE, 0, 16 }			// ETC2_RGBA8
+		};
+		return s_Formats[(unsigned int)format];
+	}
+
+	unsigned int getLevelSize(unsigned int size, unsigned int level)
+	{
+		size >>= level;
+		return size > 0 ? size : 1;
+	}
+
+	// rows of 3 or 1 byte texels aren't 4 byte aligned; GL's default unpack alignment is 4
+	void setUnpackAlignment(const FormatInfo& info)
+	{
+		if (info.bytesPerPixel != 4) {
+			GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+		}
+	}
+
+	void resetUnpackAlignment(const FormatInfo& info)
+	{
+		if (info.bytesPerPixel != 4) {
+			GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+		}
+	}
+
+}
+
+Texture::Texture(unsigned int target, unsigned int width, unsigned int height, unsigned int levels, TextureFormat format)
+	: m_RendererID(0), m_Target(target), m_Width(width > 0 ? width : 1), m_Height(height > 0 ? height : 1),
+	m_Levels(0), m_Format(format), m_SamplerState(), m_Sampler(0)
+{
+	unsigned int maxLevels = getMaxLevels(m_Width, m_Height);
+	m_Levels = levels == 0 || levels > maxLevels ? maxLevels : levels;
+	GLCall(glGenTextures(1, &m_RendererID));
+
+	// a single level can't be sampled with a mipmap filter, there's nothing to blend
+	setSampler(m_Levels > 1 ? SamplerState::trilinear() : SamplerState::linear());
+}
+
+Texture::~Texture()
+{
+	TextureUnits::onDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+void Texture::bind(unsigned int unit) const
+{
+	TextureUnits::bind(unit, m_Target, m_RendererID);
+	TextureUnits::bindSampler(unit, m_Sampler);
+}
+
+void Texture::generateMipmaps()
+{
+	ASSERT(!isCompressed(m_Format));
+	if (m_Levels < 2)
+		return;
+	PROFILE_SCOPE("Texture::generateMipmaps");
+	TextureUnits::bindForUpdate(m_Target, m_RendererID);
+	GLCall(glGenerateMipmap(m_Target));
+}
+
+void Texture::setSampler(const SamplerState& state)
+{
+	m_SamplerState = state;
+	m_Sampler = SamplerCache::get(state);
+}
+
+unsigned int Texture::getMaxLevels(unsigned int width, unsigned int height)
+{
+	unsigned int size = width > height ? width : height;
+	unsigned int levels = 1;
+	while (size > 1) {
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+unsigned long long Texture::getByteSize() const
+{
+	unsigned long long size = 0;
+	for (unsigned int level = 0; level < m_Levels; level++)
+		size += getImageSize(m_Format, getLevelSize(m_Width, level), getLevelSize(m_Height, level));
+	return size;
+}
+
+unsigned int Texture::getBytesPerPixel(TextureFormat format)
+{
+	return getFormatInfo(format).bytesPerPixel;
+}
+
+unsigned int Texture::getInternalFormat(TextureFormat format)
+{
+	return getFormatInfo(format).internalFormat;
+}
+
+bool Texture::isCompressed(TextureFormat format)
+{
+	return getFormatInfo(format).blockBytes != 0;
+}
+
+unsigned int Texture::getImageSize(TextureFormat format, unsigned int width, unsigned int height)
+{
+	const FormatInfo& info = getFormatInfo(format);
+	if (info.blockBytes == 0)
+		return width * height * info.bytesPerPixel;
+	return ((width + 3) / 4) * ((height + 3) / 4) * info.blockBytes;
+}
+
+bool Texture::isSupported(TextureFormat format)
+{
+	switch (format) {
+		case TextureFormat::BC1:
+		case TextureFormat::BC1_Alpha:
+		case TextureFormat::BC2:
+		case TextureFormat::BC3:
+			return GLEW_EXT_texture_compression_s3tc;
+		case TextureFormat::BC4:
+		case TextureFormat::BC5:
+			return true;	// core since 3.0
+		case TextureFormat::BC7:
+			return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+		case TextureFormat::ETC2_RGB8:
+		case TextureFormat::ETC2_RGBA8:
+			return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+		default:
+			return true;
+	}
+}
+
+bool Texture::hasImmutableStorage()
+{
+	return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+}
+
+Texture2D::Texture2D(unsigned int width, unsigned int height, TextureFormat format, unsigned int levels)
+	: Texture(GL_TEXTURE_2D, width, height, levels, format)
+{
+	const FormatInfo& info = getFormatInfo(m_Format);
+	TextureUnits::bindForUpdate(GL_TEXTURE_2D, m_RendererID);
+	if (hasImmutableStorage()) {
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, m_Levels, info.internalFormat, m_Width, m_Height));
+	}
+	else if (info.blockBytes != 0) {
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1));
+	}
+	else {
+		// GLCall is several statements, hence the braces
+		for (unsigned int level = 0; level < m_Levels; level++) {
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, info.internalFormat, getLevelSize(m_Width, level), getLevelSize(m_Height, level),
+				0, info.format, info.type, nullptr));
+		}
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1));
+	}
+}
+
+Texture2D::Texture2D(unsigned int width, unsigned int height, const void* pixels, TextureFormat format, unsigned int levels)
+	: Texture2D(width, height, format, levels)
+{
+	setData(pixels);
+	generateMipmaps();
+}
+
+void Texture2D::setData(const void* pixels, unsigned int level)
+{
+	setSubData(pixels, 0, 0, getLevelSize(m_Width, level), getLevelSize(m_Height, level), level);
+}
+
+void Texture2D::setSubData(const void* pixels, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int level)
+{
+	PROFILE_SCOPE("Texture2D::setSubData");
+	ASSERT(level < m_Levels && !isCompressed(m_Format));
+	ASSERT(x + width <= getLevelSize(m_Width, level) && y + height <= getLevelSize(m_Height, level));
+	const FormatInfo& info = getFormatInfo(m_Format);
+	TextureUnits::bindForUpdate(GL_TEXTURE_2D, m_RendererID);
+	setUnpackAlignment(info);
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, info.format, info.type, pixels));
+	resetUnpackAlignment(info);
+	Renderer::counters().bytesUploaded += (unsigned long long)width * height * info.bytesPerPixel;
+}
+
+void Texture2D::setCompressedData(const void* blocks, unsigned int size, unsigned int level)
+{
+	PROFILE_SCOPE("Texture2D::setCompressedData");
+	unsigned int width = getLevelSize(m_Width, level), height = getLevelSize(m_Height, level);
+	ASSERT(level < m_Levels && isCompressed(m_Format) && size == getImageSize(m_Format, width, height));
+	const FormatInfo& info = getFormatInfo(m_Format);
+	TextureUnits::bindForUpdate(GL_TEXTURE_2D, m_RendererID);
+	if (hasImmutableStorage()) {
+		GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, info.internalFormat, size, blocks));
+	}
+	else {
+		GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, info.internalFormat, width, height, 0, size, blocks));
+	}
+	Renderer::counters().bytesUploaded += size;
+}
+
+TextureArray::TextureArray(unsigned int width, unsigned int height, unsigned int layers, TextureFormat format, unsigned int levels)
+	: Texture(GL_TEXTURE_2D_ARRAY, width, height, levels, format), m_Layers(layers > 0 ? layers : 1)
+{
+	const FormatInfo& info = getFormatInfo(m_Format);
+	TextureUnits::bindForUpdate(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	if (hasImmutableStorage()) {
+		GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_Levels, info.internalFormat, m_Width, m_Height, m_Layers));
+	}
+	else {
+		for (unsigned int level = 0; level < m_Levels; level++) {
+			GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, info.internalFormat, getLevelSize(m_Width, level), getLevelSize(m_Height, level),
+				m_Layers, 0, info.format, info.type, nullptr));
+		}
+		GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_Levels - 1));
+	}
+}
+
+unsigned long long TextureArray::getByteSize() const
+{
+	return Texture::getByteSize() * m_Layers;
+}
+
+void TextureArray::setLayer(unsigned int layer, const void* pixels, unsigned int level)
+{
+	PROFILE_SCOPE("TextureArray::setLayer");
+	ASSERT(layer < m_Layers && level < m_Levels && !isCompressed(m_Format));
+	const FormatInfo& info = getFormatInfo(m_Format);
+	unsigned int width = getLevelSize(m_Width, level);
+	unsigned int height = getLevelSize(m_Height, level);
+	TextureUnits::bindForUpdate(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	setUnpackAlignment(info);
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, info.format, info.type, pixels));
+	resetUnpackAlignment(info);
+	Renderer::counters().bytesUploaded += (unsigned long long)width * height * info.bytesPerPixel;
+}
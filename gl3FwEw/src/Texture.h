@@ -0,0 +1,109 @@
+#pragma once
+
+#include "SamplerCache.h"
+
+enum class TextureFormat : unsigned char {
+	RGBA8,
+	RGB8,
+	R8,
+	SRGB8_Alpha8,
+	RGBA16F,		// HDR render targets
+	Depth24Stencil8,
+	// block compressed, 4x4 texel blocks
+	BC1,			// DXT1, RGB
+	BC1_Alpha,		// DXT1 with 1 bit alpha
+	BC2,			// DXT3
+	BC3,			// DXT5
+	BC4,			// RGTC1, red
+	BC5,			// RGTC2, red + green
+	BC7,			// BPTC
+	ETC2_RGB8,
+	ETC2_RGBA8
+};
+
+// Storage is allocated once, with every mip level, and never resized: glTexStorage when
+// GL 4.2 / ARB_texture_storage is there, otherwise each level is sized with glTexImage up
+// front and GL_TEXTURE_MAX_LEVEL set, so the texture is complete the same way (compressed
+// levels are sized by their setCompressedData instead, glTexImage can't take every
+// compressed format). Filtering and wrapping come from a shared sampler object
+// (SamplerCache), not texture parameters.
+class Texture
+{
+protected:
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	unsigned int m_Width;
+	unsigned int m_Height;
+	unsigned int m_Levels;
+	TextureFormat m_Format;
+	SamplerState m_SamplerState;
+	unsigned int m_Sampler;
+
+	Texture(unsigned int target, unsigned int width, unsigned int height, unsigned int levels, TextureFormat format);
+
+public:
+	virtual ~Texture();
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	// texture and sampler, both through TextureUnits so rebinding is free
+	void bind(unsigned int unit = 0) const;
+	// rebuilds levels 1.. from level 0; not for compressed formats
+	void generateMipmaps();
+	void setSampler(const SamplerState& state);
+
+	inline unsigned int getRendererID() const { return m_RendererID; }
+	inline unsigned int getWidth() const { return m_Width; }
+	inline unsigned int getHeight() const { return m_Height; }
+	inline unsigned int getLevels() const { return m_Levels; }
+	inline TextureFormat getFormat() const { return m_Format; }
+	inline const SamplerState& getSamplerState() const { return m_SamplerState; }
+	// GPU memory of all levels (and layers), as allocated
+	virtual unsigned long long getByteSize() const;
+
+	// levels of a full chain down to 1x1
+	static unsigned int getMaxLevels(unsigned int width, unsigned int height);
+	// 0 for compressed formats
+	static unsigned int getBytesPerPixel(TextureFormat format);
+	static bool isCompressed(TextureFormat format);
+	// bytes of one width x height image, whole blocks for compressed formats
+	static unsigned int getImageSize(TextureFormat format, unsigned int width, unsigned int height);
+	// the GL internal format, e.g. for a renderbuffer of the same format
+	static unsigned int getInternalFormat(TextureFormat format);
+	// whether the driver can sample the format (the compressed ones need extensions)
+	static bool isSupported(TextureFormat format);
+	// whether allocation uses glTexStorage
+	static bool hasImmutableStorage();
+};
+
+class Texture2D : public Texture
+{
+public:
+	// levels: 0 = the full chain
+	Texture2D(unsigned int width, unsigned int height, TextureFormat format = TextureFormat::RGBA8, unsigned int levels = 0);
+	// allocates and uploads level 0; with more than one level the mips are generated from it
+	Texture2D(unsigned int width, unsigned int height, const void* pixels, TextureFormat format = TextureFormat::RGBA8, unsigned int levels = 0);
+
+	// pixels are tightly packed rows, bottom row first
+	void setData(const void* pixels, unsigned int level = 0);
+	void setSubData(const void* pixels, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int level = 0);
+	// a whole level of a compressed format, size = getImageSize of the level; the blocks go
+	// to glCompressedTex(Sub)Image2D as they are
+	void setCompressedData(const void* blocks, unsigned int size, unsigned int level = 0);
+};
+
+// GL_TEXTURE_2D_ARRAY, every layer the same size, format and mip count; uncompressed formats.
+class TextureArray : public Texture
+{
+private:
+	unsigned int m_Layers;
+
+public:
+	TextureArray(unsigned int width, unsigned int height, unsigned int layers, TextureFormat format = TextureFormat::RGBA8, unsigned int levels = 0);
+
+	void setLayer(unsigned int layer, const void* pixels, unsigned int level = 0);
+
+	unsigned long long getByteSize() const override;
+
+	inline unsigned int getLayers() const { return m_Layers; }
+};
@@ -0,0 +1,128 @@
+#include "TextureAtlas.h"
+#include "Texture.h"
+#include "Profiler.h"
+#include <cstring>
+
+TextureAtlas::TextureAtlas(unsigned int pageSize, unsigned int padding, unsigned int maxPages)
+	: m_PageSize(pageSize > 0 ? pageSize : 1), m_Padding(padding), m_MaxPages(maxPages > 0 ? maxPages : 1), m_Levels(1)
+{
+	// a texel of mip k averages 2^k texels of level 0, at most 2^k - 1 of them outside
+	// the image; the gutter has to cover those
+	while ((2u << (m_Levels - 1)) - 1 <= m_Padding && m_Levels < Texture::getMaxLevels(m_PageSize, m_PageSize))
+		m_Levels++;
+}
+
+// out of line for the unique_ptr<Texture2D> in Page
+TextureAtlas::~TextureAtlas()
+{
+}
+
+TextureAtlas::Handle TextureAtlas::add(unsigned int width, unsigned int height, const void* rgba)
+{
+	PROFILE_SCOPE("TextureAtlas::add");
+	unsigned int paddedWidth = width + 2 * m_Padding, paddedHeight = height + 2 * m_Padding;
+	if (width == 0 || height == 0 || paddedWidth > m_PageSize || paddedHeight > m_PageSize)
+		return InvalidHandle;
+
+	unsigned int pageIndex = 0;
+	PackedRect padded;
+	for (; pageIndex < m_Pages.size(); pageIndex++)
+		if (m_Pages[pageIndex]->packer.insert(paddedWidth, paddedHeight, padded))
+			break;
+	if (pageIndex == m_Pages.size()) {
+		if (m_Pages.size() == m_MaxPages)
+			return InvalidHandle;
+		addPage().packer.insert(paddedWidth, paddedHeight, padded);
+	}
+
+	Page& page = *m_Pages[pageIndex];
+	upload(page, padded, width, height, (const unsigned char*)rgba);
+
+	Handle handle;
+	if (!m_FreeHandles.empty()) {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else {
+		handle = (Handle)m_Entries.size();
+		m_Entries.emplace_back();
+	}
+
+	Entry& entry = m_Entries[handle];
+	entry.used = true;
+	entry.padded = padded;
+	entry.region.page = pageIndex;
+	entry.region.rect = { padded.x + m_Padding, padded.y + m_Padding, width, height };
+	float scale = 1.0f / m_PageSize;
+	entry.region.uv[0] = entry.region.rect.x * scale;
+	entry.region.uv[1] = entry.region.rect.y * scale;
+	entry.region.uv[2] = (entry.region.rect.x + width) * scale;
+	entry.region.uv[3] = (entry.region.rect.y + height) * scale;
+	return handle;
+}
+
+void TextureAtlas::remove(Handle handle)
+{
+	if (handle >= m_Entries.size() || !m_Entries[handle].used)
+		return;
+	Entry& entry = m_Entries[handle];
+	m_Pages[entry.region.page]->packer.free(entry.padded);
+	entry.used = false;
+	m_FreeHandles.push_back(handle);
+}
+
+void TextureAtlas::update()
+{
+	for (std::unique_ptr<Page>& page : m_Pages) {
+		if (page->dirty) {
+			page->texture->generateMipmaps();
+			page->dirty = false;
+		}
+	}
+}
+
+const Texture2D& TextureAtlas::getPage(unsigned int page) const
+{
+	return *m_Pages[page]->texture;
+}
+
+float TextureAtlas::getOccupancy() const
+{
+	if (m_Pages.empty())
+		return 0.0f;
+	double used = 0.0;
+	for (const std::unique_ptr<Page>& page : m_Pages)
+		used += (double)page->packer.getUsedArea();
+	return (float)(used / ((double)m_PageSize * m_PageSize * m_Pages.size()));
+}
+
+TextureAtlas::Page& TextureAtlas::addPage()
+{
+	PROFILE_SCOPE("TextureAtlas::addPage");
+	m_Pages.emplace_back(new Page{ nullptr, RectPacker(m_PageSize, m_PageSize), false });
+	Page& page = *m_Pages.back();
+	page.texture.reset(new Texture2D(m_PageSize, m_PageSize, TextureFormat::RGBA8, m_Levels));
+	// clamp: sampling past a region at the page border must not wrap to the other side
+	SamplerFilter filter = m_Levels > 1 ? SamplerFilter::Trilinear : SamplerFilter::Linear;
+	page.texture->setSampler({ filter, SamplerWrap::ClampToEdge, SamplerWrap::ClampToEdge, 1 });
+	return page;
+}
+
+void TextureAtlas::upload(Page& page, const PackedRect& padded, unsigned int width, unsigned int height, const unsigned char* rgba)
+{
+	// the image in the middle, every gutter texel a copy of the nearest edge texel
+	size_t rowBytes = (size_t)padded.width * 4;
+	m_Staging.resize(rowBytes * padded.height);
+	for (unsigned int y = 0; y < padded.height; y++) {
+		unsigned int sourceY = y < m_Padding ? 0 : y - m_Padding >= height ? height - 1 : y - m_Padding;
+		const unsigned char* source = rgba + (size_t)sourceY * width * 4;
+		unsigned char* row = &m_Staging[y * rowBytes];
+		for (unsigned int x = 0; x < m_Padding; x++) {
+			memcpy(row + x * 4, source, 4);
+			memcpy(row + (m_Padding + width + x) * 4, source + (width - 1) * 4, 4);
+		}
+		memcpy(row + m_Padding * 4, source, (size_t)width * 4);
+	}
+	page.texture->setSubData(m_Staging.data(), padded.x, padded.y, padded.width, padded.height);
+	page.dirty = m_Levels > 1;
+}
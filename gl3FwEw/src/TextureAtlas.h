@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "RectPacker.h"
+
+class Texture2D;
+
+// Where an image ended up: the page texture and its uv rect (u0, v0, u1, v1), the layout
+// BatchRenderer::drawQuad and SpriteRenderer::drawSprite take.
+struct AtlasRegion {
+	unsigned int page;
+	PackedRect rect;		// texels of the image itself, without the gutter
+	float uv[4];
+};
+
+// Packs small images into a few large RGBA8 pages at runtime, so quads using different
+// images still share a texture and a batch. Images can be added and removed at any time
+// (RectPacker, MaxRects). Each image is surrounded by a gutter of `padding` texels that
+// repeats its edge texels, so bilinear filtering and the first mips don't bleed
+// neighbours in; pages get only as many mip levels as the gutter covers.
+class TextureAtlas
+{
+public:
+	typedef unsigned int Handle;
+	static const Handle InvalidHandle = ~0u;
+
+	static const unsigned int DefaultPageSize = 2048;
+	static const unsigned int DefaultPadding = 2;
+	static const unsigned int DefaultMaxPages = 8;
+
+private:
+	struct Page {
+		std::unique_ptr<Texture2D> texture;
+		RectPacker packer;
+		bool dirty;			// mips out of date
+	};
+
+	struct Entry {
+		AtlasRegion region;
+		PackedRect padded;		// what the packer handed out
+		bool used;
+	};
+
+	unsigned int m_PageSize;
+	unsigned int m_Padding;
+	unsigned int m_MaxPages;
+	unsigned int m_Levels;
+	std::vector<std::unique_ptr<Page>> m_Pages;
+	std::vector<Entry> m_Entries;
+	std::vector<Handle> m_FreeHandles;
+	std::vector<unsigned char> m_Staging;	// padded image, reused
+
+public:
+	TextureAtlas(unsigned int pageSize = DefaultPageSize, unsigned int padding = DefaultPadding, unsigned int maxPages = DefaultMaxPages);
+	~TextureAtlas();
+
+	// rgba: tightly packed RGBA8, bottom row first; InvalidHandle when all pages are full
+	// or the image is larger than a page
+	Handle add(unsigned int width, unsigned int height, const void* rgba);
+	// frees the space for later adds; the texels stay until overwritten
+	void remove(Handle handle);
+
+	// regenerates the mips of pages changed since the last call; once a frame, before drawing
+	void update();
+
+	inline const AtlasRegion& getRegion(Handle handle) const { return m_Entries[handle].region; }
+	const Texture2D& getPage(unsigned int page) const;
+	inline unsigned int getPageCount() const { return (unsigned int)m_Pages.size(); }
+	inline unsigned int getPageSize() const { return m_PageSize; }
+	// used area (gutters included) / area of the pages so far
+	float getOccupancy() const;
+
+private:
+	Page& addPage();
+	void upload(Page& page, const PackedRect& padded, unsigned int width, unsigned int height, const unsigned char* rgba);
+};
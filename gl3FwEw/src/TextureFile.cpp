@@ -0,0 +1,463 @@
+#include "TextureFile.h"
+#include "BlockDecoder.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <GL/glew.h>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	const unsigned int s_MaxDimension = 16384;
+
+	const unsigned char s_KtxIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const size_t s_KtxHeaderSize = 64;
+	const unsigned int s_KtxEndianness = 0x04030201;
+
+	const size_t s_DdsHeaderSize = 4 + 124;		// magic + DDS_HEADER
+	const size_t s_Dx10HeaderSize = 20;
+	const unsigned int s_DdpfAlphaPixels = 0x1;
+	const unsigned int s_DdpfFourCC = 0x4;
+	const unsigned int s_DdpfRgb = 0x40;
+	const unsigned int s_DdsCaps2Cubemap = 0x200;
+	const unsigned int s_DdsCaps2Volume = 0x200000;
+
+	enum DxgiFormat : unsigned int {
+		DxgiRGBA8 = 28,
+		DxgiBC1 = 71,
+		DxgiBC2 = 74,
+		DxgiBC3 = 77,
+		DxgiBC4 = 80,
+		DxgiBC5 = 83,
+		DxgiBC7 = 98
+	};
+
+	unsigned int readLE32(const unsigned char* p)
+	{
+		return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+	}
+
+	unsigned int swap32(unsigned int value)
+	{
+		return value >> 24 | (value >> 8 & 0xFF00) | (value << 8 & 0xFF0000) | value << 24;
+	}
+
+	void writeLE32(unsigned char* p, unsigned int value)
+	{
+		p[0] = (unsigned char)value;
+		p[1] = (unsigned char)(value >> 8);
+		p[2] = (unsigned char)(value >> 16);
+		p[3] = (unsigned char)(value >> 24);
+	}
+
+	unsigned int makeFourCC(const char* code)
+	{
+		return readLE32((const unsigned char*)code);
+	}
+
+	unsigned int getLevelSize(unsigned int size, unsigned int level)
+	{
+		size >>= level;
+		return size > 0 ? size : 1;
+	}
+
+	bool checkDimensions(unsigned int width, unsigned int height, unsigned int levels)
+	{
+		return width > 0 && height > 0 && width <= s_MaxDimension && height <= s_MaxDimension
+			&& levels > 0 && levels <= Texture::getMaxLevels(width, height);
+	}
+
+	bool fromGLInternalFormat(unsigned int internalFormat, unsigned int format, unsigned int type, TextureFormat& out)
+	{
+		switch (internalFormat) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:	out = TextureFormat::BC1; return true;
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:	out = TextureFormat::BC1_Alpha; return true;
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:	out = TextureFormat::BC2; return true;
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:	out = TextureFormat::BC3; return true;
+			case GL_COMPRESSED_RED_RGTC1:			out = TextureFormat::BC4; return true;
+			case GL_COMPRESSED_RG_RGTC2:			out = TextureFormat::BC5; return true;
+			case GL_COMPRESSED_RGBA_BPTC_UNORM:		out = TextureFormat::BC7; return true;
+			case GL_COMPRESSED_RGB8_ETC2:			out = TextureFormat::ETC2_RGB8; return true;
+			case GL_COMPRESSED_RGBA8_ETC2_EAC:		out = TextureFormat::ETC2_RGBA8; return true;
+			case GL_RGBA8:
+				out = TextureFormat::RGBA8;
+				return format == GL_RGBA && type == GL_UNSIGNED_BYTE;
+			default:
+				return false;
+		}
+	}
+
+	bool parseKtx(const unsigned char* data, size_t size, TextureFileInfo& info)
+	{
+		if (size < s_KtxHeaderSize)
+			return false;
+		// written big endian: only the header words need swapping, the payload is bytes
+		bool swap = readLE32(data + 12) != s_KtxEndianness;
+		unsigned int header[13];
+		for (int i = 0; i < 13; i++)
+			header[i] = swap ? swap32(readLE32(data + 12 + i * 4)) : readLE32(data + 12 + i * 4);
+		if (header[0] != s_KtxEndianness)
+			return false;
+		unsigned int type = header[1], format = header[3], internalFormat = header[4];
+		unsigned int depth = header[8], arrayElements = header[9], faces = header[10];
+		if (!fromGLInternalFormat(internalFormat, format, type, info.format)) {
+			LOG_ERROR("TextureFile: unsupported KTX internal format 0x%X", internalFormat);
+			return false;
+		}
+		if (depth > 1 || arrayElements > 0 || faces != 1) {
+			LOG_ERROR("TextureFile: only 2D KTX textures are supported");
+			return false;
+		}
+		info.width = header[6];
+		info.height = header[7];
+		unsigned int levels = header[11] > 0 ? header[11] : 1;
+		if (!checkDimensions(info.width, info.height, levels))
+			return false;
+
+		size_t offset = s_KtxHeaderSize + header[12];
+		info.levels.clear();
+		for (unsigned int level = 0; level < levels; level++) {
+			if (offset + 4 > size)
+				return false;
+			unsigned int imageSize = readLE32(data + offset);
+			if (swap)
+				imageSize = swap32(imageSize);
+			offset += 4;
+			unsigned int expected = Texture::getImageSize(info.format, getLevelSize(info.width, level), getLevelSize(info.height, level));
+			if (imageSize != expected || offset + imageSize > size)
+				return false;
+			info.levels.push_back({ data + offset, imageSize });
+			// mipPadding: every level starts 4 byte aligned
+			offset += (imageSize + 3) & ~3u;
+		}
+		return true;
+	}
+
+	bool fromDxgiFormat(unsigned int dxgi, TextureFormat& out)
+	{
+		switch (dxgi) {
+			case DxgiRGBA8:	out = TextureFormat::RGBA8; return true;
+			case DxgiBC1:	out = TextureFormat::BC1_Alpha; return true;
+			case DxgiBC2:	out = TextureFormat::BC2; return true;
+			case DxgiBC3:	out = TextureFormat::BC3; return true;
+			case DxgiBC4:	out = TextureFormat::BC4; return true;
+			case DxgiBC5:	out = TextureFormat::BC5; return true;
+			case DxgiBC7:	out = TextureFormat::BC7; return true;
+			default:		return false;
+		}
+	}
+
+	bool parseDds(const unsigned char* data, size_t size, TextureFileInfo& info)
+	{
+		if (size < s_DdsHeaderSize || readLE32(data + 4) != 124)
+			return false;
+		const unsigned char* header = data + 4;
+		info.height = readLE32(header + 8);
+		info.width = readLE32(header + 12);
+		unsigned int levels = readLE32(header + 24);
+		levels = levels > 0 ? levels : 1;
+		const unsigned char* pixelFormat = header + 72;
+		unsigned int flags = readLE32(pixelFormat + 4), fourCC = readLE32(pixelFormat + 8);
+		if (readLE32(header + 108) & (s_DdsCaps2Cubemap | s_DdsCaps2Volume)) {
+			LOG_ERROR("TextureFile: only 2D DDS textures are supported");
+			return false;
+		}
+
+		size_t offset = s_DdsHeaderSize;
+		if ((flags & s_DdpfFourCC) && fourCC == makeFourCC("DX10")) {
+			if (size < offset + s_Dx10HeaderSize)
+				return false;
+			const unsigned char* dx10 = data + offset;
+			unsigned int dxgi = readLE32(dx10);
+			// resource dimension 3 = 2D, misc flag 4 = cube, one array element
+			if (readLE32(dx10 + 4) != 3 || (readLE32(dx10 + 8) & 4) || readLE32(dx10 + 12) > 1) {
+				LOG_ERROR("TextureFile: only 2D DDS textures are supported");
+				return false;
+			}
+			if (!fromDxgiFormat(dxgi, info.format)) {
+				LOG_ERROR("TextureFile: unsupported DXGI format %u", dxgi);
+				return false;
+			}
+			offset += s_Dx10HeaderSize;
+		}
+		else if (flags & s_DdpfFourCC) {
+			if (fourCC == makeFourCC("DXT1"))
+				info.format = flags & s_DdpfAlphaPixels ? TextureFormat::BC1_Alpha : TextureFormat::BC1;
+			else if (fourCC == makeFourCC("DXT2") || fourCC == makeFourCC("DXT3"))
+				info.format = TextureFormat::BC2;
+			else if (fourCC == makeFourCC("DXT4") || fourCC == makeFourCC("DXT5"))
+				info.format = TextureFormat::BC3;
+			else if (fourCC == makeFourCC("ATI1") || fourCC == makeFourCC("BC4U"))
+				info.format = TextureFormat::BC4;
+			else if (fourCC == makeFourCC("ATI2") || fourCC == makeFourCC("BC5U"))
+				info.format = TextureFormat::BC5;
+			else {
+				LOG_ERROR("TextureFile: unsupported DDS FourCC %.4s", (const char*)pixelFormat + 8);
+				return false;
+			}
+		}
+		else if ((flags & s_DdpfRgb) && readLE32(pixelFormat + 12) == 32
+			&& readLE32(pixelFormat + 16) == 0xFF && readLE32(pixelFormat + 20) == 0xFF00
+			&& readLE32(pixelFormat + 24) == 0xFF0000 && readLE32(pixelFormat + 28) == 0xFF000000u) {
+			info.format = TextureFormat::RGBA8;
+		}
+		else {
+			// BGRA and the other channel orders would need a swizzle, i.e. a copy
+			LOG_ERROR("TextureFile: unsupported DDS pixel format");
+			return false;
+		}
+		if (!checkDimensions(info.width, info.height, levels))
+			return false;
+
+		info.levels.clear();
+		for (unsigned int level = 0; level < levels; level++) {
+			unsigned int imageSize = Texture::getImageSize(info.format, getLevelSize(info.width, level), getLevelSize(info.height, level));
+			if (offset + imageSize > size)
+				return false;
+			info.levels.push_back({ data + offset, imageSize });
+			offset += imageSize;
+		}
+		info.topDown = true;
+		return true;
+	}
+
+	// source texel row of each destination row inside a flipped block; a level lower than a
+	// block only flips the rows it has
+	void getBlockRows(unsigned int height, unsigned int rows[4])
+	{
+		for (unsigned int r = 0; r < 4; r++)
+			rows[r] = height >= 4 ? 3 - r : (r < height ? height - 1 - r : r);
+	}
+
+	// BC1 colors: two endpoints, then one byte of 2 bit indices per row
+	void flipColorBlock(const unsigned char* src, unsigned char* dst, const unsigned int rows[4])
+	{
+		memcpy(dst, src, 4);
+		for (unsigned int r = 0; r < 4; r++)
+			dst[4 + r] = src[4 + rows[r]];
+	}
+
+	// BC3 alpha / BC4: two endpoints, then 12 bits of 3 bit indices per row
+	void flipAlphaBlock(const unsigned char* src, unsigned char* dst, const unsigned int rows[4])
+	{
+		unsigned long long bits = 0, flipped = 0;
+		for (int i = 0; i < 6; i++)
+			bits |= (unsigned long long)src[2 + i] << (8 * i);
+		for (unsigned int r = 0; r < 4; r++)
+			flipped |= (bits >> (12 * rows[r]) & 0xFFF) << (12 * r);
+		dst[0] = src[0];
+		dst[1] = src[1];
+		for (int i = 0; i < 6; i++)
+			dst[2 + i] = (unsigned char)(flipped >> (8 * i));
+	}
+
+	// BC2 alpha: 4 bits per texel, two bytes per row
+	void flipExplicitAlphaBlock(const unsigned char* src, unsigned char* dst, const unsigned int rows[4])
+	{
+		for (unsigned int r = 0; r < 4; r++) {
+			dst[2 * r] = src[2 * rows[r]];
+			dst[2 * r + 1] = src[2 * rows[r] + 1];
+		}
+	}
+
+	bool canFlipBlocks(TextureFormat format, unsigned int height)
+	{
+		switch (format) {
+			case TextureFormat::BC1:
+			case TextureFormat::BC1_Alpha:
+			case TextureFormat::BC2:
+			case TextureFormat::BC3:
+			case TextureFormat::BC4:
+			case TextureFormat::BC5:
+				// otherwise rows would have to move across block boundaries
+				return height < 4 || height % 4 == 0;
+			default:
+				return false;
+		}
+	}
+
+	void flipRows(const unsigned char* src, unsigned char* dst, size_t rowBytes, unsigned int height)
+	{
+		for (unsigned int y = 0; y < height; y++)
+			memcpy(dst + (size_t)(height - 1 - y) * rowBytes, src + (size_t)y * rowBytes, rowBytes);
+	}
+
+	// a level of a top-down file into GL row order; src and dst don't overlap
+	void flipLevel(TextureFormat format, const unsigned char* src, unsigned int width, unsigned int height, unsigned char* dst)
+	{
+		if (!Texture::isCompressed(format)) {
+			flipRows(src, dst, Texture::getImageSize(format, width, 1), height);
+			return;
+		}
+		unsigned int rows[4];
+		getBlockRows(height, rows);
+		unsigned int blockBytes = Texture::getImageSize(format, 4, 4);
+		unsigned int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		size_t rowBytes = (size_t)blocksX * blockBytes;
+		for (unsigned int y = 0; y < blocksY; y++) {
+			const unsigned char* srcBlock = src + (size_t)(blocksY - 1 - y) * rowBytes;
+			unsigned char* dstBlock = dst + (size_t)y * rowBytes;
+			for (unsigned int x = 0; x < blocksX; x++, srcBlock += blockBytes, dstBlock += blockBytes) {
+				switch (format) {
+					case TextureFormat::BC2:
+						flipExplicitAlphaBlock(srcBlock, dstBlock, rows);
+						flipColorBlock(srcBlock + 8, dstBlock + 8, rows);
+						break;
+					case TextureFormat::BC3:
+						flipAlphaBlock(srcBlock, dstBlock, rows);
+						flipColorBlock(srcBlock + 8, dstBlock + 8, rows);
+						break;
+					case TextureFormat::BC4:
+						flipAlphaBlock(srcBlock, dstBlock, rows);
+						break;
+					case TextureFormat::BC5:
+						flipAlphaBlock(srcBlock, dstBlock, rows);
+						flipAlphaBlock(srcBlock + 8, dstBlock + 8, rows);
+						break;
+					default:
+						flipColorBlock(srcBlock, dstBlock, rows);
+						break;
+				}
+			}
+		}
+	}
+
+}
+
+bool TextureFile::parse(const unsigned char* data, size_t size, TextureFileInfo& info)
+{
+	if (size >= sizeof(s_KtxIdentifier) && memcmp(data, s_KtxIdentifier, sizeof(s_KtxIdentifier)) == 0)
+		return parseKtx(data, size, info);
+	if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+		return parseDds(data, size, info);
+	return false;
+}
+
+std::unique_ptr<Texture2D> TextureFile::load(const std::string& path, bool allowCompressed)
+{
+	PROFILE_SCOPE("TextureFile::load");
+	MappedFile file(path);
+	if (!file.isValid()) {
+		LOG_ERROR("TextureFile: can't open %s", path.c_str());
+		return nullptr;
+	}
+	TextureFileInfo info;
+	if (!parse(file.getData(), file.getSize(), info)) {
+		LOG_ERROR("TextureFile: can't parse %s", path.c_str());
+		return nullptr;
+	}
+	std::unique_ptr<Texture2D> texture = createTexture(info, 0, allowCompressed);
+	if (!texture)
+		LOG_ERROR("TextureFile: %s: format not supported by the driver and no software decoder", path.c_str());
+	return texture;
+}
+
+std::unique_ptr<Texture2D> TextureFile::createTexture(const TextureFileInfo& info, unsigned int firstLevel, bool allowCompressed)
+{
+	PROFILE_SCOPE("TextureFile::createTexture");
+	if (firstLevel >= info.levels.size())
+		return nullptr;
+	unsigned int width = getLevelSize(info.width, firstLevel), height = getLevelSize(info.height, firstLevel);
+	unsigned int levels = (unsigned int)info.levels.size() - firstLevel;
+	bool compressed = Texture::isCompressed(info.format);
+	bool upload = !compressed || (allowCompressed && Texture::isSupported(info.format));
+	bool flip = info.topDown;
+	if (flip && upload && compressed) {
+		for (unsigned int level = 0; level < levels && upload; level++)
+			upload = canFlipBlocks(info.format, getLevelSize(height, level));
+		if (!upload && !BlockDecoder::canDecode(info.format)) {
+			LOG_WARN("TextureFile: these blocks can't be flipped, the texture stays upside down");
+			upload = true;
+			flip = false;
+		}
+	}
+	if (!upload && !BlockDecoder::canDecode(info.format))
+		return nullptr;
+
+	std::unique_ptr<Texture2D> texture(new Texture2D(width, height, upload ? info.format : TextureFormat::RGBA8, levels));
+	std::vector<unsigned char> flipped, rgba;
+	for (unsigned int level = 0; level < levels; level++) {
+		const TextureFileLevel& source = info.levels[firstLevel + level];
+		unsigned int levelWidth = getLevelSize(width, level), levelHeight = getLevelSize(height, level);
+		if (!upload) {
+			rgba.resize((size_t)levelWidth * levelHeight * 4);
+			BlockDecoder::decode(info.format, source.data, source.size, levelWidth, levelHeight, rgba.data());
+			if (flip) {
+				flipped.resize(rgba.size());
+				flipRows(rgba.data(), flipped.data(), (size_t)levelWidth * 4, levelHeight);
+				rgba.swap(flipped);
+			}
+			texture->setData(rgba.data(), level);
+			continue;
+		}
+		const unsigned char* data = source.data;
+		if (flip) {
+			flipped.resize(source.size);
+			flipLevel(info.format, source.data, levelWidth, levelHeight, flipped.data());
+			data = flipped.data();
+		}
+		if (compressed)
+			texture->setCompressedData(data, source.size, level);
+		else
+			texture->setData(data, level);
+	}
+	return texture;
+}
+
+bool TextureFile::writeDds(const char* path, const TextureFileInfo& info)
+{
+	unsigned char header[s_DdsHeaderSize + s_Dx10HeaderSize] = {};
+	memcpy(header, "DDS ", 4);
+	unsigned char* dds = header + 4;
+	unsigned char* pixelFormat = dds + 72;
+	writeLE32(dds, 124);
+	// caps | height | width | pixel format | mipmap count
+	writeLE32(dds + 4, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000);
+	writeLE32(dds + 8, info.height);
+	writeLE32(dds + 12, info.width);
+	writeLE32(dds + 24, (unsigned int)info.levels.size());
+	writeLE32(pixelFormat, 32);
+	writeLE32(dds + 104, 0x1000);	// DDSCAPS_TEXTURE
+	size_t headerSize = s_DdsHeaderSize;
+
+	const char* fourCC = nullptr;
+	switch (info.format) {
+		case TextureFormat::BC1:		fourCC = "DXT1"; break;
+		case TextureFormat::BC1_Alpha:	fourCC = "DXT1"; break;
+		case TextureFormat::BC2:		fourCC = "DXT3"; break;
+		case TextureFormat::BC3:		fourCC = "DXT5"; break;
+		case TextureFormat::BC4:		fourCC = "ATI1"; break;
+		case TextureFormat::BC5:		fourCC = "ATI2"; break;
+		case TextureFormat::BC7:		fourCC = "DX10"; break;
+		case TextureFormat::RGBA8:
+			writeLE32(pixelFormat + 4, s_DdpfRgb | s_DdpfAlphaPixels);
+			writeLE32(pixelFormat + 12, 32);
+			writeLE32(pixelFormat + 16, 0xFF);
+			writeLE32(pixelFormat + 20, 0xFF00);
+			writeLE32(pixelFormat + 24, 0xFF0000);
+			writeLE32(pixelFormat + 28, 0xFF000000u);
+			break;
+		default:
+			return false;
+	}
+	if (fourCC) {
+		writeLE32(pixelFormat + 4, s_DdpfFourCC | (info.format == TextureFormat::BC1_Alpha ? s_DdpfAlphaPixels : 0));
+		writeLE32(pixelFormat + 8, makeFourCC(fourCC));
+	}
+	if (info.format == TextureFormat::BC7) {
+		unsigned char* dx10 = header + s_DdsHeaderSize;
+		writeLE32(dx10, DxgiBC7);
+		writeLE32(dx10 + 4, 3);
+		writeLE32(dx10 + 12, 1);
+		headerSize += s_Dx10HeaderSize;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+	bool ok = fwrite(header, 1, headerSize, file) == headerSize;
+	for (const TextureFileLevel& level : info.levels)
+		ok = ok && fwrite(level.data, 1, level.size, file) == level.size;
+	return fclose(file) == 0 && ok;
+}
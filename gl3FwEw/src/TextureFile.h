@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Texture.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TextureFileLevel {
+	const unsigned char* data;		// points into the file's memory
+	unsigned int size;
+};
+
+struct TextureFileInfo {
+	TextureFormat format;
+	unsigned int width;
+	unsigned int height;
+	std::vector<TextureFileLevel> levels;	// level 0 first
+	bool topDown = false;					// rows stored top row first (DDS), flipped on upload
+};
+
+// GPU texture containers: KTX 1.1 and DDS (legacy FourCC or the DX10 header), 2D textures
+// only, no cube maps or arrays. Payloads are BC1 - BC5, BC7, ETC2 (KTX only) or plain RGBA8.
+// KTX rows are in GL order. DDS stores the top row first; createTexture() flips those levels
+// like every other loader: RGBA8 by rows, BC1 - BC5 by reversing the block rows and the
+// texel rows inside each block, which is lossless. A level whose height is neither below 4
+// nor a multiple of 4 can't be flipped in blocks and goes through the software decoder. BC7
+// can't be flipped without re-encoding and stays as stored (with a warning).
+class TextureFile
+{
+public:
+	// level pointers point into data, nothing is copied
+	static bool parse(const unsigned char* data, size_t size, TextureFileInfo& info);
+
+	// Maps the file and hands each level straight from the mapping to the driver. A
+	// compressed format the driver can't sample (or any, with allowCompressed false) is
+	// decoded to RGBA8 in software when BlockDecoder can; nullptr if neither works.
+	static std::unique_ptr<Texture2D> load(const std::string& path, bool allowCompressed = true);
+	// the same from parsed levels: levels firstLevel.. become the texture's 0..; the data
+	// has to stay valid for the call only
+	static std::unique_ptr<Texture2D> createTexture(const TextureFileInfo& info, unsigned int firstLevel = 0, bool allowCompressed = true);
+
+	// DDS with the legacy header for BC1 - BC5, DX10 for BC7, for tests and tools; levels
+	// are written as given, readers take their first row as the top
+	static bool writeDds(const char* path, const TextureFileInfo& info);
+};
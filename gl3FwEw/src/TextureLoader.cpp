@@ -0,0 +1,281 @@
+#include "TextureLoader.h"
+#include "ImageDecoder.h"
+#include "Texture.h"
+#include "Renderer.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+TextureLoader::TextureLoader(unsigned int workers, unsigned int bytesPerFrame)
+	: m_UploadRow(0), m_PixelBuffer(0), m_PixelBufferSize(0), m_BytesPerFrame(bytesPerFrame),
+	m_LastFrameBytes(0), m_Pending(0), m_PooledBytes(0), m_Stopping(false)
+{
+	unsigned int grey = 0xff808080;
+	m_Placeholder.reset(new Texture2D(1, 1, &grey));
+	m_Placeholder->setSampler(SamplerState::nearest());
+	GLCall(glGenBuffers(1, &m_PixelBuffer));
+
+	if (workers < 1)
+		workers = 1;
+	for (unsigned int i = 0; i < workers; i++)
+		m_Workers.emplace_back(&TextureLoader::workerLoop, this, i);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_JobReady.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+
+	GLCall(glDeleteBuffers(1, &m_PixelBuffer));
+}
+
+TextureLoader::Handle TextureLoader::load(const std::string& path, bool mipmaps)
+{
+	Handle handle = (Handle)m_Entries.size();
+	m_Entries.push_back({ path, TextureLoadState::Queued, mipmaps, nullptr });
+	m_Pending++;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back({ handle, path });
+	}
+	m_JobReady.notify_one();
+	return handle;
+}
+
+const Texture2D& TextureLoader::get(Handle handle) const
+{
+	const Entry& entry = m_Entries[handle];
+	return entry.state == TextureLoadState::Ready ? *entry.texture : *m_Placeholder;
+}
+
+TextureLoadState TextureLoader::getState(Handle handle) const
+{
+	return m_Entries[handle].state;
+}
+
+void TextureLoader::update()
+{
+	PROFILE_SCOPE("TextureLoader::update");
+	collectDecoded();
+	m_LastFrameBytes = m_Uploads.empty() ? 0 : upload(m_BytesPerFrame);
+}
+
+void TextureLoader::finish()
+{
+	PROFILE_SCOPE("TextureLoader::finish");
+	while (m_Pending > 0) {
+		collectDecoded();
+		// bounded passes: one pass over everything would size the pixel buffer for all of it
+		if (!m_Uploads.empty())
+			upload(m_BytesPerFrame > DefaultBytesPerFrame ? m_BytesPerFrame : DefaultBytesPerFrame);
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void TextureLoader::workerLoop(unsigned int index)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "TextureLoader %u", index);
+	Profiler::setThreadName(name);
+
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobReady.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+			if (m_Stopping)
+				return;
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		Decoded decoded = { job.handle, 0, 0, {} };
+		decode(job, decoded);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Decoded.push_back(std::move(decoded));
+	}
+}
+
+void TextureLoader::decode(const Job& job, Decoded& decoded)
+{
+	PROFILE_SCOPE("TextureLoader::decode");
+	FILE* file = fopen(job.path.c_str(), "rb");
+	if (!file) {
+		LOG_WARN("TextureLoader: can't open %s", job.path.c_str());
+		return;
+	}
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	std::vector<unsigned char> data = acquireStaging(fileSize > 0 ? (size_t)fileSize : 1);
+	size_t size = fileSize > 0 ? fread(data.data(), 1, (size_t)fileSize, file) : 0;
+	fclose(file);
+
+	ImageInfo info;
+	if (ImageDecoder::readInfo(data.data(), size, info)) {
+		decoded.pixels = acquireStaging((size_t)info.width * info.height * 4);
+		if (ImageDecoder::decode(data.data(), size, info, decoded.pixels.data())) {
+			decoded.width = info.width;
+			decoded.height = info.height;
+		}
+		else {
+			releaseStaging(std::move(decoded.pixels));
+			decoded.pixels = std::vector<unsigned char>();
+		}
+	}
+	if (decoded.pixels.empty())
+		LOG_WARN("TextureLoader: can't decode %s", job.path.c_str());
+	releaseStaging(std::move(data));
+}
+
+void TextureLoader::collectDecoded()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		while (!m_Decoded.empty()) {
+			m_Uploads.push_back(std::move(m_Decoded.front()));
+			m_Decoded.pop_front();
+		}
+	}
+
+	// failures never reach the GPU, drop them right away (uploads keep their order)
+	for (auto it = m_Uploads.begin(); it != m_Uploads.end();) {
+		Entry& entry = m_Entries[it->handle];
+		if (it->pixels.empty()) {
+			entry.state = TextureLoadState::Failed;
+			m_Pending--;
+			it = m_Uploads.erase(it);
+		}
+		else {
+			entry.state = TextureLoadState::Uploading;
+			++it;
+		}
+	}
+}
+
+size_t TextureLoader::upload(size_t budget)
+{
+	PROFILE_SCOPE("TextureLoader::upload");
+
+	// plan: whole rows, in order, until the budget is spent; at least one row so a row
+	// wider than the budget still makes progress
+	struct Chunk {
+		unsigned int firstRow;
+		unsigned int rows;
+		size_t offset;			// into the pixel buffer
+	};
+	Chunk chunks[16];
+	unsigned int chunkCount = 0;
+	size_t total = 0;
+	for (size_t i = 0; i < m_Uploads.size() && chunkCount < 16; i++) {
+		const Decoded& decoded = m_Uploads[i];
+		size_t rowBytes = (size_t)decoded.width * 4;
+		unsigned int firstRow = i == 0 ? m_UploadRow : 0;
+		unsigned int rows = decoded.height - firstRow;
+		size_t fit = (budget - total) / rowBytes;
+		if (fit < rows)
+			rows = total == 0 && fit == 0 ? 1 : (unsigned int)fit;
+		if (rows == 0)
+			break;
+		chunks[chunkCount++] = { firstRow, rows, total };
+		total += rows * rowBytes;
+		if (total >= budget)
+			break;
+	}
+
+	// before the unpack buffer is bound: without texture storage the allocation is a
+	// glTexImage2D per level, whose nullptr would be read as an offset into it
+	for (unsigned int i = 0; i < chunkCount; i++) {
+		const Decoded& decoded = m_Uploads[i];
+		Entry& entry = m_Entries[decoded.handle];
+		if (chunks[i].firstRow == 0)
+			entry.texture.reset(new Texture2D(decoded.width, decoded.height, TextureFormat::RGBA8, entry.mipmaps ? 0 : 1));
+	}
+
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer));
+	if (total > m_PixelBufferSize) {
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW));
+		m_PixelBufferSize = total;
+	}
+	{
+		PROFILE_SCOPE("TextureLoader::copy");
+		// invalidating orphans last frame's contents if the GPU still reads them
+		GLCall(unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)total,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if (!mapped) {
+			GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+			return 0;
+		}
+		for (unsigned int i = 0; i < chunkCount; i++) {
+			const Decoded& decoded = m_Uploads[i];
+			size_t rowBytes = (size_t)decoded.width * 4;
+			memcpy(mapped + chunks[i].offset, decoded.pixels.data() + (size_t)chunks[i].firstRow * rowBytes, chunks[i].rows * rowBytes);
+		}
+		GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+	}
+
+	// with an unpack buffer bound the pixel pointer is an offset into it
+	for (unsigned int i = 0; i < chunkCount; i++) {
+		const Decoded& decoded = m_Uploads[i];
+		Entry& entry = m_Entries[decoded.handle];
+		entry.texture->setSubData((const void*)(uintptr_t)chunks[i].offset, 0, chunks[i].firstRow, decoded.width, chunks[i].rows);
+	}
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+	// the finished ones are at the front
+	for (unsigned int i = 0; i < chunkCount; i++) {
+		Decoded& decoded = m_Uploads.front();
+		if (chunks[i].firstRow + chunks[i].rows < decoded.height) {
+			m_UploadRow = chunks[i].firstRow + chunks[i].rows;
+			break;
+		}
+		Entry& entry = m_Entries[decoded.handle];
+		entry.texture->generateMipmaps();
+		entry.state = TextureLoadState::Ready;
+		m_Pending--;
+		m_UploadRow = 0;
+		releaseStaging(std::move(decoded.pixels));
+		m_Uploads.pop_front();
+	}
+	return total;
+}
+
+std::vector<unsigned char> TextureLoader::acquireStaging(size_t size)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		// smallest pooled buffer that fits
+		size_t best = m_Pool.size();
+		for (size_t i = 0; i < m_Pool.size(); i++)
+			if (m_Pool[i].size() >= size && (best == m_Pool.size() || m_Pool[i].size() < m_Pool[best].size()))
+				best = i;
+		if (best < m_Pool.size()) {
+			std::vector<unsigned char> buffer = std::move(m_Pool[best]);
+			m_Pool[best] = std::move(m_Pool.back());
+			m_Pool.pop_back();
+			m_PooledBytes -= buffer.size();
+			return buffer;
+		}
+	}
+	return std::vector<unsigned char>(size);
+}
+
+void TextureLoader::releaseStaging(std::vector<unsigned char>&& buffer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (buffer.empty() || m_PooledBytes + buffer.size() > MaxPooledBytes)
+		return;		// not taken, the caller's vector frees it
+	m_PooledBytes += buffer.size();
+	m_Pool.push_back(std::move(buffer));
+}
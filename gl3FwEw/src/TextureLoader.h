@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Texture2D;
+
+enum class TextureLoadState {
+	Queued,			// waiting for or on a worker
+	Uploading,		// decoded, going to the GPU a few rows per frame
+	Ready,
+	Failed			// unreadable or undecodable, the placeholder stays
+};
+
+// Loads image files (see ImageDecoder) into textures without stalling the render loop.
+// Worker threads read and decode into pooled staging memory; update(), called once a frame
+// on the GL thread, copies at most bytesPerFrame of decoded rows into a pixel unpack buffer
+// and uploads them with glTexSubImage2D, so a large image arrives over several frames.
+// Until a texture is Ready, get() returns a 1x1 grey placeholder.
+class TextureLoader
+{
+public:
+	typedef unsigned int Handle;
+
+	static const unsigned int DefaultWorkers = 2;
+	static const unsigned int DefaultBytesPerFrame = 4 << 20;
+	// staging memory kept for reuse once uploads are done, beyond that buffers are freed
+	static const size_t MaxPooledBytes = 64 << 20;
+
+private:
+	struct Job {
+		Handle handle;
+		std::string path;
+	};
+
+	struct Decoded {
+		Handle handle;
+		unsigned int width;
+		unsigned int height;
+		std::vector<unsigned char> pixels;		// RGBA8, empty = failed
+	};
+
+	struct Entry {
+		std::string path;
+		TextureLoadState state;
+		bool mipmaps;
+		std::unique_ptr<Texture2D> texture;
+	};
+
+	// GL thread only
+	std::vector<Entry> m_Entries;
+	std::deque<Decoded> m_Uploads;		// front one is partly uploaded
+	unsigned int m_UploadRow;			// next row of the front upload
+	unsigned int m_PixelBuffer;
+	size_t m_PixelBufferSize;
+	unsigned int m_BytesPerFrame;
+	size_t m_LastFrameBytes;
+	unsigned int m_Pending;				// Queued + Uploading
+	std::unique_ptr<Texture2D> m_Placeholder;
+
+	// shared with the workers, under m_Mutex
+	std::mutex m_Mutex;
+	std::condition_variable m_JobReady;
+	std::deque<Job> m_Jobs;
+	std::deque<Decoded> m_Decoded;
+	std::vector<std::vector<unsigned char>> m_Pool;
+	size_t m_PooledBytes;
+	bool m_Stopping;
+
+	std::vector<std::thread> m_Workers;
+
+public:
+	TextureLoader(unsigned int workers = DefaultWorkers, unsigned int bytesPerFrame = DefaultBytesPerFrame);
+	~TextureLoader();
+
+	// queues the file; mipmaps are generated once the last row is uploaded
+	Handle load(const std::string& path, bool mipmaps = true);
+	// the texture, or the placeholder until it's Ready
+	const Texture2D& get(Handle handle) const;
+	TextureLoadState getState(Handle handle) const;
+
+	// GL thread, once per frame: starts uploads the workers finished and spends the budget
+	void update();
+	// blocks until nothing is Queued or Uploading, at least DefaultBytesPerFrame per pass
+	// whatever the frame budget is; for loading screens
+	void finish();
+
+	inline unsigned int getPendingCount() const { return m_Pending; }
+	inline size_t getLastFrameBytes() const { return m_LastFrameBytes; }
+	inline void setBytesPerFrame(unsigned int bytes) { m_BytesPerFrame = bytes; }
+
+private:
+	void workerLoop(unsigned int index);
+	void decode(const Job& job, Decoded& decoded);
+	void collectDecoded();
+	// copies up to budget bytes of whole rows through the pixel buffer, returns the bytes
+	size_t upload(size_t budget);
+
+	std::vector<unsigned char> acquireStaging(size_t size);
+	void releaseStaging(std::vector<unsigned char>&& buffer);
+};
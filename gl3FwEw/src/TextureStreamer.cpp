@@ -0,0 +1,193 @@
+#include "TextureStreamer.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	unsigned int getLevelSize(unsigned int size, unsigned int level)
+	{
+		size >>= level;
+		return size > 0 ? size : 1;
+	}
+
+}
+
+TextureStreamer::TextureStreamer(unsigned long long budget, unsigned int bytesPerFrame)
+	: m_Budget(budget), m_BytesPerFrame(bytesPerFrame), m_Frame(0), m_ResidentBytes(0), m_LastFrameBytes(0), m_Evictions(0)
+{
+}
+
+// out of line for the unique_ptr<MappedFile> in Entry
+TextureStreamer::~TextureStreamer()
+{
+}
+
+TextureStreamer::Handle TextureStreamer::load(const std::string& path)
+{
+	PROFILE_SCOPE("TextureStreamer::load");
+	Entry entry;
+	entry.file.reset(new MappedFile(path));
+	if (!entry.file->isValid() || !TextureFile::parse(entry.file->getData(), entry.file->getSize(), entry.info)) {
+		LOG_ERROR("TextureStreamer: can't load %s", path.c_str());
+		return InvalidHandle;
+	}
+	unsigned int levels = (unsigned int)entry.info.levels.size();
+	entry.tailLevel = 0;
+	while (entry.tailLevel + 1 < levels && std::max(getLevelSize(entry.info.width, entry.tailLevel), getLevelSize(entry.info.height, entry.tailLevel)) > TailSize)
+		entry.tailLevel++;
+	entry.residentLevel = levels;
+	entry.wantedLevel = entry.tailLevel;
+	entry.reportedLevel = ~0u;
+	entry.lastUsedFrame = m_Frame;
+	entry.residentBytes = 0;
+	setResidentLevel(entry, entry.tailLevel);
+	if (!entry.texture) {
+		LOG_ERROR("TextureStreamer: %s: format not supported by the driver and no software decoder", path.c_str());
+		return InvalidHandle;
+	}
+	entry.gpuFormat = entry.texture->getFormat();
+	m_Entries.push_back(std::move(entry));
+	return (Handle)m_Entries.size() - 1;
+}
+
+void TextureStreamer::reportUsage(Handle handle, float screenSize)
+{
+	Entry& entry = m_Entries[handle];
+	// the level whose size matches the screen size, the sampler won't read finer ones
+	unsigned int size = std::max(entry.info.width, entry.info.height);
+	unsigned int level = entry.tailLevel;
+	if (screenSize >= 1.0f)
+		level = std::min(entry.tailLevel, (unsigned int)std::max(0.0f, std::floor(std::log2(size / screenSize))));
+	entry.reportedLevel = std::min(entry.reportedLevel, level);
+}
+
+void TextureStreamer::update()
+{
+	PROFILE_SCOPE("TextureStreamer::update");
+	m_LastFrameBytes = 0;
+	m_Frame++;
+	m_Candidates.clear();
+	for (Handle handle = 0; handle < m_Entries.size(); handle++) {
+		Entry& entry = m_Entries[handle];
+		if (entry.reportedLevel != ~0u) {
+			entry.wantedLevel = entry.reportedLevel;
+			entry.reportedLevel = ~0u;
+			entry.lastUsedFrame = m_Frame;
+			if (entry.residentLevel > entry.wantedLevel)
+				m_Candidates.push_back(handle);
+		}
+	}
+	// the budget may have shrunk
+	if (m_ResidentBytes > m_Budget) {
+		collectVictims(InvalidHandle);
+		m_LastFrameBytes += evict(m_ResidentBytes - m_Budget);
+	}
+
+	// the blurriest first
+	std::sort(m_Candidates.begin(), m_Candidates.end(), [this](Handle a, Handle b) {
+		unsigned int missingA = m_Entries[a].residentLevel - m_Entries[a].wantedLevel;
+		unsigned int missingB = m_Entries[b].residentLevel - m_Entries[b].wantedLevel;
+		return missingA != missingB ? missingA > missingB : a < b;
+	});
+	// only upgrades count against bytesPerFrame, the re-uploads evictions cause don't
+	unsigned long long upgradeBytes = 0;
+	for (Handle handle : m_Candidates) {
+		Entry& entry = m_Entries[handle];
+		unsigned int target = entry.wantedLevel;
+		// one upgrade per frame always goes through, so a level larger than the budget still arrives
+		while (target < entry.residentLevel && upgradeBytes > 0 && upgradeBytes + getChainBytes(entry, target) > m_BytesPerFrame)
+			target++;
+		// settle on what fits before evicting anything for it
+		unsigned long long evictable = collectVictims(handle);
+		while (target < entry.residentLevel && m_ResidentBytes + getChainBytes(entry, target) - entry.residentBytes > m_Budget + evictable)
+			target++;
+		if (target == entry.residentLevel)
+			continue;
+		unsigned long long needed = m_ResidentBytes + getChainBytes(entry, target) - entry.residentBytes;
+		if (needed > m_Budget)
+			m_LastFrameBytes += evict(needed - m_Budget);
+		unsigned long long bytes = setResidentLevel(entry, target);
+		upgradeBytes += bytes;
+		m_LastFrameBytes += bytes;
+	}
+}
+
+const Texture2D& TextureStreamer::get(Handle handle) const
+{
+	return *m_Entries[handle].texture;
+}
+
+unsigned long long TextureStreamer::getChainBytes(const Entry& entry, unsigned int level) const
+{
+	unsigned long long bytes = 0;
+	for (; level < entry.info.levels.size(); level++)
+		bytes += Texture::getImageSize(entry.gpuFormat, getLevelSize(entry.info.width, level), getLevelSize(entry.info.height, level));
+	return bytes;
+}
+
+unsigned int TextureStreamer::getEvictLimit(const Entry& entry) const
+{
+	// textures used this frame only give up detail finer than they are used at
+	return entry.lastUsedFrame == m_Frame ? entry.wantedLevel : entry.tailLevel;
+}
+
+unsigned long long TextureStreamer::collectVictims(Handle requester)
+{
+	m_Victims.clear();
+	unsigned long long evictable = 0;
+	for (Handle handle = 0; handle < m_Entries.size(); handle++) {
+		const Entry& entry = m_Entries[handle];
+		unsigned int limit = getEvictLimit(entry);
+		if (handle != requester && entry.residentLevel < limit) {
+			m_Victims.push_back(handle);
+			evictable += entry.residentBytes - getChainBytes(entry, limit);
+		}
+	}
+	return evictable;
+}
+
+unsigned long long TextureStreamer::evict(unsigned long long bytes)
+{
+	PROFILE_SCOPE("TextureStreamer::evict");
+	std::sort(m_Victims.begin(), m_Victims.end(), [this](Handle a, Handle b) {
+		const Entry& entryA = m_Entries[a];
+		const Entry& entryB = m_Entries[b];
+		if (entryA.lastUsedFrame != entryB.lastUsedFrame)
+			return entryA.lastUsedFrame < entryB.lastUsedFrame;
+		return entryA.residentBytes > entryB.residentBytes;
+	});
+
+	unsigned long long freed = 0;
+	unsigned long long uploaded = 0;
+	for (Handle handle : m_Victims) {
+		Entry& entry = m_Entries[handle];
+		unsigned int limit = getEvictLimit(entry);
+		// as few levels as cover the rest
+		unsigned int level = entry.residentLevel + 1;
+		while (level < limit && freed + entry.residentBytes - getChainBytes(entry, level) < bytes)
+			level++;
+		freed += entry.residentBytes - getChainBytes(entry, level);
+		m_Evictions += level - entry.residentLevel;
+		uploaded += setResidentLevel(entry, level);
+		if (freed >= bytes)
+			break;
+	}
+	return uploaded;
+}
+
+unsigned long long TextureStreamer::setResidentLevel(Entry& entry, unsigned int level)
+{
+	std::unique_ptr<Texture2D> texture = TextureFile::createTexture(entry.info, level);
+	if (!texture)
+		return 0;
+	unsigned long long bytes = texture->getByteSize();
+	m_ResidentBytes += bytes;
+	m_ResidentBytes -= entry.residentBytes;
+	entry.texture = std::move(texture);
+	entry.residentLevel = level;
+	entry.residentBytes = bytes;
+	return bytes;
+}
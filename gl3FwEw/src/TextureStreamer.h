@@ -0,0 +1,93 @@
+#pragma once
+
+#include "TextureFile.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// Mip streaming for KTX / DDS textures (see TextureFile) under a VRAM budget. load() maps
+// the file and uploads only the mip tail (levels of TailSize and smaller), which always
+// stays resident. Each frame the renderer reports how large a texture is on screen; update()
+// turns that into the finest level worth having and moves textures toward it, within
+// bytesPerFrame of upgrades and the budget. When an upgrade doesn't fit, textures not used
+// for the longest time (or holding more detail than they are used at) give up their finest
+// levels first.
+//
+// GL 3.3 has no sparse textures, so a residency change allocates a texture of exactly the
+// resident levels and fills it from the mapping; get() returns a different object afterwards
+// and normalized coordinates stay valid.
+class TextureStreamer
+{
+public:
+	typedef unsigned int Handle;
+
+	static const Handle InvalidHandle = ~0u;
+	static const unsigned long long DefaultBudget = 256ull << 20;
+	static const unsigned int DefaultBytesPerFrame = 4 << 20;
+	static const unsigned int TailSize = 64;
+
+private:
+	struct Entry {
+		std::unique_ptr<MappedFile> file;
+		TextureFileInfo info;				// level pointers into file
+		std::unique_ptr<Texture2D> texture;
+		TextureFormat gpuFormat;			// RGBA8 when the driver can't take info.format
+		unsigned int tailLevel;				// finest level of the tail, never dropped
+		unsigned int residentLevel;			// finest level on the GPU
+		unsigned int wantedLevel;			// from the last frame it was used in
+		unsigned int reportedLevel;			// this frame's, ~0u = not used yet
+		unsigned long long lastUsedFrame;
+		unsigned long long residentBytes;
+	};
+
+	std::vector<Entry> m_Entries;
+	unsigned long long m_Budget;
+	unsigned int m_BytesPerFrame;
+	unsigned long long m_Frame;
+	unsigned long long m_ResidentBytes;
+	unsigned long long m_LastFrameBytes;
+	unsigned long long m_Evictions;
+	std::vector<Handle> m_Candidates;		// scratch for update()
+	std::vector<Handle> m_Victims;			// from collectVictims(), for evict()
+
+public:
+	TextureStreamer(unsigned long long budget = DefaultBudget, unsigned int bytesPerFrame = DefaultBytesPerFrame);
+	~TextureStreamer();
+
+	// uploads the mip tail right away; InvalidHandle if the file can't be used
+	Handle load(const std::string& path);
+	// screenSize: the largest extent the texture covers on screen this frame, in pixels;
+	// reports of one frame are combined, the largest wins
+	void reportUsage(Handle handle, float screenSize);
+	// GL thread, once per frame, after the frame's reports
+	void update();
+
+	// changes with the residency, fetch it every frame; samplers set on it don't survive that
+	const Texture2D& get(Handle handle) const;
+	inline unsigned int getResidentLevel(Handle handle) const { return m_Entries[handle].residentLevel; }
+	inline unsigned int getWantedLevel(Handle handle) const { return m_Entries[handle].wantedLevel; }
+	inline unsigned int getTextureCount() const { return (unsigned int)m_Entries.size(); }
+	// the tails count too, they may push this over the budget
+	inline unsigned long long getResidentBytes() const { return m_ResidentBytes; }
+	inline unsigned long long getBudget() const { return m_Budget; }
+	inline void setBudget(unsigned long long budget) { m_Budget = budget; }
+	// uploads of the last update(), the smaller chains of evictions included
+	inline unsigned long long getLastFrameBytes() const { return m_LastFrameBytes; }
+	// levels given up for the budget, over the streamer's lifetime
+	inline unsigned long long getEvictions() const { return m_Evictions; }
+
+private:
+	// resident bytes with levels level.. on the GPU
+	unsigned long long getChainBytes(const Entry& entry, unsigned int level) const;
+	// the coarsest level an eviction may leave entry at
+	unsigned int getEvictLimit(const Entry& entry) const;
+	// textures that can give up levels for requester into m_Victims, returns what they'd free
+	unsigned long long collectVictims(Handle requester);
+	// frees at least bytes (when the victims have it) by dropping levels, LRU first; returns
+	// the bytes the smaller chains re-uploaded
+	unsigned long long evict(unsigned long long bytes);
+	// reallocates with levels level.., returns the bytes uploaded
+	unsigned long long setResidentLevel(Entry& entry, unsigned int level);
+};
@@ -0,0 +1,103 @@
+#include "TextureUnits.h"
+#include "Renderer.h"
+
+namespace {
+
+	struct UnitState {
+		unsigned int target;
+		unsigned int texture;
+		unsigned int sampler;
+	};
+
+	// ~0 = unknown, never equal to a real name, so the first bind always goes through
+	const unsigned int s_Unknown = ~0u;
+
+	UnitState s_Units[TextureUnits::MaxUnits];
+	unsigned int s_ActiveUnit = s_Unknown;
+	bool s_Valid = false;
+	unsigned long long s_SkippedBinds = 0;
+
+	void ensureValid()
+	{
+		if (s_Valid)
+			return;
+		for (unsigned int i = 0; i < TextureUnits::MaxUnits; i++)
+			s_Units[i] = { s_Unknown, s_Unknown, s_Unknown };
+		s_ActiveUnit = s_Unknown;
+		s_Valid = true;
+	}
+
+	void setActiveUnit(unsigned int unit)
+	{
+		if (s_ActiveUnit == unit)
+			return;
+		GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+		s_ActiveUnit = unit;
+	}
+
+}
+
+void TextureUnits::bind(unsigned int unit, unsigned int target, unsigned int texture)
+{
+	ASSERT(unit < MaxUnits);
+	ensureValid();
+	UnitState& state = s_Units[unit];
+	if (state.target == target && state.texture == texture) {
+		s_SkippedBinds++;
+		return;
+	}
+
+	setActiveUnit(unit);
+	GLCall(glBindTexture(target, texture));
+	// a unit holds one texture per target; we only track the last one, which is the one drawn with
+	state.target = target;
+	state.texture = texture;
+	Renderer::counters().textureBinds++;
+}
+
+void TextureUnits::bindSampler(unsigned int unit, unsigned int sampler)
+{
+	ASSERT(unit < MaxUnits);
+	ensureValid();
+	UnitState& state = s_Units[unit];
+	if (state.sampler == sampler) {
+		s_SkippedBinds++;
+		return;
+	}
+
+	// glBindSampler takes the unit, no glActiveTexture needed
+	GLCall(glBindSampler(unit, sampler));
+	state.sampler = sampler;
+	Renderer::counters().samplerBinds++;
+}
+
+void TextureUnits::bindForUpdate(unsigned int target, unsigned int texture)
+{
+	ensureValid();
+	bind(s_ActiveUnit < MaxUnits ? s_ActiveUnit : 0, target, texture);
+}
+
+void TextureUnits::onDeleteTexture(unsigned int texture)
+{
+	// GL unbinds a deleted texture from every unit, so 0 is what's bound now
+	for (unsigned int i = 0; i < MaxUnits; i++)
+		if (s_Units[i].texture == texture)
+			s_Units[i].texture = 0;
+}
+
+void TextureUnits::onDeleteSampler(unsigned int sampler)
+{
+	for (unsigned int i = 0; i < MaxUnits; i++)
+		if (s_Units[i].sampler == sampler)
+			s_Units[i].sampler = 0;
+}
+
+void TextureUnits::invalidate()
+{
+	s_Valid = false;
+}
+
+unsigned long long TextureUnits::getSkippedBinds()
+{
+	return s_SkippedBinds;
+}
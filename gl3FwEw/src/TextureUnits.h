@@ -0,0 +1,25 @@
+#pragma once
+
+// Shadows the texture and sampler bound to every texture unit, plus the active unit, so
+// binding what's already bound costs no GL call. Everything binding textures goes through
+// here; code that calls glBindTexture / glActiveTexture / glBindSampler directly has to
+// call invalidate() afterwards. Single threaded, like the rest of the GL calls.
+class TextureUnits
+{
+public:
+	static const unsigned int MaxUnits = 32;
+
+	static void bind(unsigned int unit, unsigned int target, unsigned int texture);
+	static void bindSampler(unsigned int unit, unsigned int sampler);
+	// binds to the active unit, for uploads that only need the texture bound somewhere
+	static void bindForUpdate(unsigned int target, unsigned int texture);
+
+	// forget deleted objects: GL reuses names, a stale entry would skip a needed bind
+	static void onDeleteTexture(unsigned int texture);
+	static void onDeleteSampler(unsigned int sampler);
+	// state unknown, the next binds go to GL
+	static void invalidate();
+
+	// binds skipped because the unit already had the object, since the start
+	static unsigned long long getSkippedBinds();
+};
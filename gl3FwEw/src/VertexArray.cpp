@@ -1,40 +1,61 @@
 #include "VertexArray.h"
 #include "Renderer.h"
+#include "FrameCapture.h"
 
 VertexArray::VertexArray()
+	: m_AttributeCount(0)
 {
 	glGenVertexArrays(1, &m_RendererID);
+	FrameCapture::onCreateVertexArray(m_RendererID);
 }
 
 VertexArray::~VertexArray()
 {
+	FrameCapture::onDeleteVertexArray(m_RendererID);
 	glDeleteVertexArrays(1, &m_RendererID);
 }
 
 void VertexArray::addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	addBuffer(vb, layout, 0);
+}
+
+void VertexArray::addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute)
 {
 	bind();
 	vb.bind();
 	const auto& elements = layout.getElements();
-	unsigned int offset = 0;
+	size_t offset = 0;
 	for (unsigned int i=0; i<elements.size(); i++)
 	{
 		const auto& element = elements[i];
+		unsigned int index = firstAttribute + i;
 		// below code for vertex array object concept: keep still at the first time, later can remove
-		glEnableVertexAttribArray(i);			// index: it's the index we want to enable attribute.
-		glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.getStride(), (const void*) offset);
+		glEnableVertexAttribArray(index);			// index: it's the index we want to enable attribute.
+		glVertexAttribPointer(index, element.count, element.type, element.normalized, layout.getStride(), (const void*) offset);
 		// above code ends
+		// advance once per N instances instead of per vertex; 0 resets what an instanced layout left here
+		glVertexAttribDivisor(index, layout.getDivisor());
 		offset += element.count * VertexBufferElement::getSizeOfType(element.type);
 	}
-	
+
+	FrameCapture::onAddBuffer(m_RendererID, vb.getRendererID(), layout, firstAttribute);
+
+	if (firstAttribute + elements.size() > m_AttributeCount)
+		m_AttributeCount = firstAttribute + (unsigned int)elements.size();
 }
 
 void VertexArray::bind() const
 {
+	Renderer::counters().vertexArrayBinds++;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindVertexArray(m_RendererID);
 	glBindVertexArray(m_RendererID);
 }
 
 void VertexArray::unbind() const
 {
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindVertexArray(0);
 	glBindVertexArray(0);
 }
\ No newline at end of file
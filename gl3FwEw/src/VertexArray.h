@@ -7,11 +7,17 @@ class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_AttributeCount;	// one past the highest attribute set so far
 public:
 	VertexArray();
 	~VertexArray();
 
+	// the layout's elements become attributes 0..
 	void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// ... or firstAttribute.., e.g. getAttributeCount() to follow a buffer added before
+	void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute);
 	void bind() const;
 	void unbind() const;
+
+	inline unsigned int getAttributeCount() const { return m_AttributeCount; }
 };
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "Profiler.h"
+#include "FrameCapture.h"
 #include <GL/glew.h>
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+	: m_Size(size)
 {
+	PROFILE_SCOPE("VertexBuffer::upload");
 	GLCall(glGenBuffers(1, &m_RendererID));					
 	// above: Generate/Create a GL Buffer, we should provide an Integer as a memory which we can write into 
 
@@ -13,18 +17,51 @@ VertexBuffer::VertexBuffer(const void* data, unsigned int size)
 														// if we use glBindBuffer(GL_ARRAY_BUFFER, 0); then GPU won't draw the triangle out since we bind something else
 
 	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+	Renderer::counters().bytesUploaded += size;
+	FrameCapture::onCreateBuffer(m_RendererID, GL_ARRAY_BUFFER, data, size);
 	// above: Set data which we want to use to the specific GPU buffer
 	// : STATIC, DYNAMIC: we should let GPU knows that if the buffer can be modified more than ONCE.
 	// : DRAW: we want to draw things with the buffer, so use it
 }
 
+VertexBuffer::VertexBuffer(unsigned int size)
+	: m_Size(size)
+{
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+	// above: allocate only, DYNAMIC because we'll keep rewriting it
+	FrameCapture::onCreateBuffer(m_RendererID, GL_ARRAY_BUFFER, nullptr, size);
+}
+
+void VertexBuffer::setData(const void* data, unsigned int size, unsigned int offset)
+{
+	PROFILE_SCOPE("VertexBuffer::setData");
+	ASSERT(offset + size <= m_Size);
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+	Renderer::counters().bytesUploaded += size;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBufferSubData(m_RendererID, offset, data, size);
+}
+
+void VertexBuffer::orphan()
+{
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+}
+
 VertexBuffer::~VertexBuffer()
 {
+	FrameCapture::onDeleteBuffer(m_RendererID);
 	GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void VertexBuffer::bind() const
 {
+	Renderer::counters().vertexBufferBinds++;
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));// How do I want to use the GL Buffer? Define it to a specific buffer:
 														//	target - GL_ARRAY_BUFFER: it's just an array
 														//	buffer - an integer comes from memory
@@ -34,6 +71,8 @@ void VertexBuffer::bind() const
 
 void VertexBuffer::unbind() const
 {
+	if (FrameCapture::isCapturing())
+		FrameCapture::onBindBuffer(GL_ARRAY_BUFFER, 0);
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));		// How do I want to use the GL Buffer? Define it to a specific buffer:
 													//	target - GL_ARRAY_BUFFER: it's just an array
 													//	buffer - an integer comes from memory
@@ -4,10 +4,20 @@ class VertexBuffer
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_Size;
 public:
 	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(unsigned int size);	// dynamic buffer, filled later with setData
 	~VertexBuffer();
 
+	// overwrite part of the buffer; offset + size must fit
+	void setData(const void* data, unsigned int size, unsigned int offset = 0);
+	// drops the contents so the next setData doesn't wait for draws still reading them
+	void orphan();
+
 	void bind() const;
 	void unbind() const;
+
+	inline unsigned int getSize() const { return m_Size; }
+	inline unsigned int getRendererID() const { return m_RendererID; }
 };
@@ -15,6 +15,7 @@ struct VertexBufferElement
 		switch (type) {
 			case GL_FLOAT:			return 4;
 			case GL_UNSIGNED_INT:	return 4;
+			case GL_UNSIGNED_SHORT:	return 2;
 			case GL_UNSIGNED_BYTE:	return 1;
 		}
 
@@ -28,35 +29,45 @@ class VertexBufferLayout
 private:
 	std::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride;
+	unsigned int m_Divisor;		// 0 = per vertex, N = advance every N instances
 
 public:
 	VertexBufferLayout() 
-		: m_Stride(0) {}
+		: m_Stride(0), m_Divisor(0) {}
 
 	template<typename T>
 	void push(unsigned int count) {
-		static_assert(false);
-
+		static_assert(sizeof(T) == 0, "unsupported vertex attribute type");
 	}
 
-	template<>
-	void push<float>(unsigned int count) {
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::getSizeOfType(GL_FLOAT); // 4 bytes
-	}
+	inline const std::vector<VertexBufferElement>& getElements() const { return m_Elements; }
+	inline unsigned int getStride() const { return m_Stride; }
 
-	template<>
-	void push<unsigned int>(unsigned int count) {
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT);	// 4 bytes
-	}
+	inline void setDivisor(unsigned int divisor) { m_Divisor = divisor; }
+	inline unsigned int getDivisor() const { return m_Divisor; }
+};
 
-	template<>
-	void push<unsigned char>(unsigned int count) {
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE);	// 1 byte
-	}
+// specializations live at namespace scope, MSVC is the only compiler accepting them inside the class
+template<>
+inline void VertexBufferLayout::push<float>(unsigned int count) {
+	m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
+	m_Stride += count * VertexBufferElement::getSizeOfType(GL_FLOAT); // 4 bytes
+}
 
-	inline const std::vector<VertexBufferElement> getElements() const { return m_Elements; }
-	inline unsigned int getStride() const { return m_Stride; }
-};
\ No newline at end of file
+template<>
+inline void VertexBufferLayout::push<unsigned int>(unsigned int count) {
+	m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
+	m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT);	// 4 bytes
+}
+
+template<>
+inline void VertexBufferLayout::push<unsigned short>(unsigned int count) {
+	m_Elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE });
+	m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_SHORT);	// 2 bytes
+}
+
+template<>
+inline void VertexBufferLayout::push<unsigned char>(unsigned int count) {
+	m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
+	m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE);	// 1 byte
+}
\ No newline at end of file
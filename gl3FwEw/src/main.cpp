@@ -1,9 +1,12 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
-#include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
 
 #include "Renderer.h"
 #include "VertexBuffer.h"
@@ -11,13 +14,24 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Shader.h"
+#include "Presenter.h"
+#include "RenderScheduler.h"
+#include "FramePacer.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "FrameCapture.h"
+#include "BatchRenderer.h"
+#include "TextureLoader.h"
+#include "SamplerCache.h"
+#include "RenderGraph.h"
+#include "Log.h"
 
 static ShaderProgramSources parseShader(const std::string& filepath) {
 
 	enum class ShaderType {
 		NONE = -1, VERTEX = 0, FRAGMENT = 1
 	};
-	std::cout << filepath << std::endl;
+	LOG_DEBUG("%s", filepath.c_str());
 	std::ifstream stream(filepath);
 	std::string line;
 	std::stringstream ss[2];
@@ -62,9 +76,7 @@ static unsigned int compileShader(unsigned int type, const std::string& source)
 		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
 		char* message = (char*)alloca(length * sizeof(char));
 		glGetShaderInfoLog(id, length, &length, message);
-		std::cout << "Failed to compile " <<
-			(type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
-		std::cout << message << std::endl;
+		LOG_ERROR("Failed to compile %s shader!\n%s", type == GL_VERTEX_SHADER ? "vertex" : "fragment", message);
 		glDeleteShader(id);
 		return 0;
 	}
@@ -89,10 +101,96 @@ static int createShader(const std::string& vertexShader, const std::string& frag
 }
 
 
-int main(void)
+int main(int argc, char** argv)
 {
 	GLFWwindow* window;
 
+	// --present uncapped|vsync|adaptive|<fps>
+	// --on-demand: only render when something changed
+	// --frames-in-flight 1..3: how far the CPU may run ahead of the GPU
+	// --profile file.json: write a Chrome trace of the last --profile-frames frames (default 120)
+	//   on exit and print the CPU + GPU timings of the last frame
+	// --stats: print the average draw / bind / upload counts every Renderer::StatsHistory frames
+	// --gl-trace file.bin: trace every GLCall; the trace is written on the first GL error,
+	//   when F12 is pressed and on exit (decode it with gl3FwEwTraceDecode)
+	// --capture file.cap: capture --capture-frames frames (default 1) starting at frame
+	//   --capture-at (default 60) for gl3FwEwReplay
+	// --overlay N: draw an N quad grid over the scene through the batch renderer
+	// --textures a.tga,b.ppm: load the images in the background and draw them in a row
+	//   along the top, grey until each one is ready
+	// --msaa N: render the scene into an N sample render graph target and resolve it to
+	//   the window
+	// --log file.txt: write the log to a file instead of stderr
+	// --verbose: log debug messages too, e.g. the shader sources
+	PresentMode presentMode = PresentMode::VSync;
+	double targetFps = 0.0;
+	bool onDemand = false;
+	unsigned int framesInFlight = 2;
+	const char* profilePath = nullptr;
+	unsigned int profileFrames = 120;
+	bool showStats = false;
+	const char* glTracePath = nullptr;
+	const char* capturePath = nullptr;
+	unsigned int captureAt = 60;
+	unsigned int captureFrames = 1;
+	const char* logPath = nullptr;
+	unsigned int overlayQuads = 0;
+	unsigned int msaaSamples = 0;
+	std::vector<std::string> texturePaths;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+			if (!Presenter::parseMode(argv[++i], presentMode, targetFps)) {
+				LOG_ERROR("Unknown present mode: %s", argv[i]);
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+			onDemand = true;
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+			framesInFlight = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			profilePath = argv[++i];
+		else if (strcmp(argv[i], "--profile-frames") == 0 && i + 1 < argc)
+			profileFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--stats") == 0)
+			showStats = true;
+		else if (strcmp(argv[i], "--gl-trace") == 0 && i + 1 < argc)
+			glTracePath = argv[++i];
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			capturePath = argv[++i];
+		else if (strcmp(argv[i], "--capture-at") == 0 && i + 1 < argc)
+			captureAt = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--capture-frames") == 0 && i + 1 < argc)
+			captureFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--overlay") == 0 && i + 1 < argc)
+			overlayQuads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--textures") == 0 && i + 1 < argc) {
+			std::stringstream list(argv[++i]);
+			std::string path;
+			while (std::getline(list, path, ','))
+				if (!path.empty())
+					texturePaths.push_back(path);
+		}
+		else if (strcmp(argv[i], "--msaa") == 0 && i + 1 < argc)
+			msaaSamples = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+			logPath = argv[++i];
+		else if (strcmp(argv[i], "--verbose") == 0)
+			Log::setLevel(LogLevel::Debug);
+	}
+
+	if (logPath)
+		Log::setFile(logPath);
+
+	Profiler::setThreadName("Main");
+	Profiler::setEnabled(profilePath != nullptr);
+	if (glTracePath) {
+		GLTracer::enable();
+		GLTracer::setDumpOnError(glTracePath);
+	}
+	if (capturePath)
+		FrameCapture::enable();
+
 	/* Initialize the library */
 	if (!glfwInit())
 		return -1;
@@ -113,16 +211,15 @@ int main(void)
 	/* Make the window's context current */
 	glfwMakeContextCurrent(window);
 
-	glfwSwapInterval(1);
+	Presenter presenter(window, presentMode, targetFps);
 	// above code:
-	// synchronize better with slower rate
-	// : interval - The minimum number of screen updates to wait for until the buffers are swapped by glfwSwapBuffers.
+	// synchronize better with slower rate, or cap/uncap the frame rate, see Presenter
 
 	if (glewInit() != GLEW_OK) {
-		std::cout << "Error!" << std::endl;
+		LOG_ERROR("Error!");
 	};
 
-	std::cout << "GL_VERSION: " << glGetString(GL_VERSION) << std::endl;
+	LOG_INFO("GL_VERSION: %s", (const char*)glGetString(GL_VERSION));
 	float positions[] = {
 		-0.5f, -0.5f,	// 0
 		 0.5f, -0.5f,	// 1
@@ -163,38 +260,149 @@ int main(void)
 
 		float r = 0.0f;
 		float increment = 0.05f;
-
-		while (!glfwWindowShouldClose(window))
+		unsigned int statsFrames = 0;
+		unsigned int frameIndex = 0;
+		bool dumpKeyDown = false;
+
+		RenderScheduler scheduler(window, onDemand);
+		FramePacer pacer(framesInFlight);
+		Renderer renderer;
+		GpuProfiler gpuProfiler;
+		std::unique_ptr<Shader> batchShader;
+		std::unique_ptr<BatchRenderer> batch;
+		if (overlayQuads > 0 || !texturePaths.empty()) {
+			batchShader.reset(new Shader("res/shaders/batch.shader"));
+			batch.reset(new BatchRenderer(renderer, *batchShader));
+		}
+		std::unique_ptr<TextureLoader> textureLoader;
+		std::vector<TextureLoader::Handle> textures;
+		if (!texturePaths.empty()) {
+			textureLoader.reset(new TextureLoader());
+			for (const std::string& path : texturePaths)
+				textures.push_back(textureLoader->load(path));
+		}
+		RenderTargetPool renderTargets;
+		RenderGraph renderGraph(renderTargets);
+		while (scheduler.waitForFrame())
 		{
-			/* Render here */
-			glClear(GL_COLOR_BUFFER_BIT);
+			Profiler::markFrame();
+			PROFILE_SCOPE("Frame");
+			gpuProfiler.beginFrame();
+			pacer.beginFrame();
+#if PROFILING
+			// ends right before endFrame(), a block scope would have to span the whole frame
+			gpuProfiler.beginScope("Frame");
+#endif
+			if (capturePath && frameIndex++ == captureAt)
+				FrameCapture::begin(capturePath, captureFrames);
+
+			if (textureLoader)
+				textureLoader->update();
 
-			// TODO: modern gl codes begin:
-			shader.bind();
-			shader.setUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
-			glBindVertexArray(vao);
-			vertexArray.bind();
-			indexBuffer.bind();
+			/* Render here */
+			int framebufferWidth, framebufferHeight;
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+			renderGraph.reset();
+			RenderGraph::Resource windowTarget = renderGraph.importWindow(framebufferWidth, framebufferHeight);
+			RenderGraph::Resource sceneTarget = windowTarget;
+			if (msaaSamples > 1 && framebufferWidth > 0 && framebufferHeight > 0) {
+				FramebufferSpec spec = { (unsigned int)framebufferWidth, (unsigned int)framebufferHeight, TextureFormat::RGBA8, 1, true, msaaSamples };
+				sceneTarget = renderGraph.createTarget("scene", spec);
+			}
 
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+			unsigned int scenePass = renderGraph.addPass("scene", [&](const RenderGraph& graph) {
+				graph.bind(sceneTarget);
+				renderer.clear();
+
+				// TODO: modern gl codes begin:
+				shader.bind();
+				shader.setUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
+
+				{
+					PROFILE_SCOPE("draw");
+					GPU_PROFILE_SCOPE(gpuProfiler, "draw");
+					renderer.draw(vertexArray, indexBuffer, shader);
+				}
+
+				if (batch) {
+					PROFILE_SCOPE("overlay");
+					GPU_PROFILE_SCOPE(gpuProfiler, "overlay");
+					int width = framebufferWidth, height = framebufferHeight;
+					float projection[16];
+					BatchRenderer::ortho(0.0f, (float)width, 0.0f, (float)height, projection);
+
+					unsigned int columns = overlayQuads > 0 ? (unsigned int)ceil(sqrt((double)overlayQuads)) : 1;
+					unsigned int rows = (overlayQuads + columns - 1) / columns;
+					float cellWidth = (float)width / columns;
+					float cellHeight = (float)height / rows;
+					batch->begin(projection);
+					for (unsigned int i = 0; i < overlayQuads; i++) {
+						unsigned int column = i % columns, row = i / columns;
+						float color[4] = { (float)column / columns, r, (float)row / rows, 1.0f };
+						batch->drawQuad(column * cellWidth, row * cellHeight, cellWidth * 0.8f, cellHeight * 0.8f, color);
+					}
+					float textureSize = (float)width / (textures.size() > 4 ? textures.size() : 4);
+					for (size_t i = 0; i < textures.size(); i++)
+						batch->drawQuad(i * textureSize, height - textureSize, textureSize, textureSize, &textureLoader->get(textures[i]));
+					batch->end();
+				}
+			});
+			renderGraph.write(scenePass, sceneTarget);
+			if (sceneTarget != windowTarget) {
+				unsigned int resolvePass = renderGraph.addPass("resolve", [&](const RenderGraph& graph) {
+					GPU_PROFILE_SCOPE(gpuProfiler, "resolve");
+					graph.getFramebuffer(sceneTarget)->resolve(graph.getFramebuffer(windowTarget));
+				});
+				renderGraph.read(resolvePass, sceneTarget);
+				renderGraph.write(resolvePass, windowTarget);
+			}
+			renderGraph.execute();
+			renderTargets.endFrame();
 
 			if (r > 1.0f) increment = -0.05f;
 			else if (r < 0.0f) increment = 0.05f;
 			r += increment;
 
-			/* Swap front and back buffers */
-			glfwSwapBuffers(window);
+			// when rendering on demand the animation only ticks twice a second
+			if (scheduler.isOnDemand())
+				scheduler.invalidateAfter(0.5);
+
+#if PROFILING
+			gpuProfiler.endScope();
+#endif
+			gpuProfiler.endFrame();
 
-			/* Poll for and process events */
-			glfwPollEvents();
+			renderer.endFrame();
+			if (showStats && ++statsFrames % Renderer::StatsHistory == 0)
+				renderer.printStats();
+
+			if (glTracePath) {
+				bool down = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+				if (down && !dumpKeyDown && GLTracer::dump(glTracePath))
+					LOG_INFO("GL trace written to %s", glTracePath);
+				dumpKeyDown = down;
+			}
+
+			/* Swap front and back buffers */
+			presenter.present();
+			pacer.endFrame();
 		}
 
-		
+		if (profilePath) {
+			gpuProfiler.flush();
+			if (gpuProfiler.getLastResolvedFrame() >= 0)
+				Profiler::printFrameReport(gpuProfiler.getLastResolvedFrame());
+			Profiler::exportChromeTrace(profilePath, profileFrames);
+		}
+		if (glTracePath)
+			GLTracer::dump(glTracePath);
 	}
 	// above code ends: add a scope
 
 	// TODO: delete vertex buffer and index buffer here
+	SamplerCache::clear();
 	glfwTerminate();
+	Log::shutdown();
 
 	return 0;
 }
\ No newline at end of file
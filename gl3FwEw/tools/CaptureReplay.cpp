@@ -0,0 +1,451 @@
+// Replays a FrameCapture file headless: runs the setup once, then re-issues the captured
+// frames in a loop and reports CPU submit and GPU frame time percentiles as JSON.
+// The framebuffer is hashed after the first and the last loop, so a driver that
+// renders the capture differently from run to run shows up as "deterministic": false.
+//
+// usage: gl3FwEwReplay capture.cap [--loops N] [--warmup W] [--out file.json]
+
+#include "HeadlessContext.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "VertexBufferLayout.h"
+#include "FrameCapture.h"
+#include "Log.h"
+#include "BenchUtils.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// bounds-checked reads from the command stream
+class CaptureReader
+{
+private:
+	const std::vector<unsigned char>& m_Data;
+	size_t m_Position;
+	bool m_Failed;
+
+public:
+	CaptureReader(const std::vector<unsigned char>& data)
+		: m_Data(data), m_Position(0), m_Failed(false) {}
+
+	inline bool isAtEnd() const { return m_Position >= m_Data.size() || m_Failed; }
+	inline bool hasFailed() const { return m_Failed; }
+	inline size_t getPosition() const { return m_Position; }
+	inline void seek(size_t position) { m_Position = position; }
+
+	const unsigned char* getBytes(size_t size) {
+		if (m_Failed || m_Data.size() - m_Position < size) {
+			m_Failed = true;
+			return nullptr;
+		}
+		const unsigned char* bytes = m_Data.data() + m_Position;
+		m_Position += size;
+		return bytes;
+	}
+
+	unsigned char getByte() {
+		const unsigned char* byte = getBytes(1);
+		return byte ? *byte : 0;
+	}
+
+	unsigned int getUInt() {
+		unsigned int value = 0;
+		if (const unsigned char* bytes = getBytes(sizeof(value)))
+			memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	float getFloat() {
+		float value = 0.0f;
+		if (const unsigned char* bytes = getBytes(sizeof(value)))
+			memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	std::string getString() {
+		unsigned int length = getUInt();
+		const unsigned char* bytes = getBytes(length);
+		return bytes ? std::string((const char*)bytes, length) : std::string();
+	}
+};
+
+// GL objects of the replay, keyed by the names they had when captured
+class Replayer
+{
+private:
+	std::unordered_map<unsigned int, unsigned int> m_Buffers;
+	std::unordered_map<unsigned int, unsigned int> m_VertexArrays;
+	std::unordered_map<unsigned int, std::unique_ptr<Shader>> m_Programs;
+	Shader* m_CurrentProgram;
+	unsigned int m_UnknownNames;
+
+	unsigned int map(const std::unordered_map<unsigned int, unsigned int>& names, unsigned int name) {
+		if (name == 0)
+			return 0;
+		auto found = names.find(name);
+		if (found == names.end()) {
+			m_UnknownNames++;
+			return 0;
+		}
+		return found->second;
+	}
+
+	void deleteBuffer(unsigned int name) {
+		auto found = m_Buffers.find(name);
+		if (found != m_Buffers.end()) {
+			GLCall(glDeleteBuffers(1, &found->second));
+			m_Buffers.erase(found);
+		}
+	}
+
+	void deleteVertexArray(unsigned int name) {
+		auto found = m_VertexArrays.find(name);
+		if (found != m_VertexArrays.end()) {
+			GLCall(glDeleteVertexArrays(1, &found->second));
+			m_VertexArrays.erase(found);
+		}
+	}
+
+public:
+	unsigned int draws;
+
+	Replayer() : m_CurrentProgram(nullptr), m_UnknownNames(0), draws(0) {}
+
+	~Replayer() {
+		while (!m_Buffers.empty())
+			deleteBuffer(m_Buffers.begin()->first);
+		while (!m_VertexArrays.empty())
+			deleteVertexArray(m_VertexArrays.begin()->first);
+	}
+
+	inline unsigned int getUnknownNameCount() const { return m_UnknownNames; }
+
+	// runs commands until `stop` (EndSetup / EndFrame) or the end of the stream; false on a bad stream
+	bool execute(CaptureReader& reader, FrameCapture::Command stop) {
+		while (!reader.isAtEnd()) {
+			FrameCapture::Command command = (FrameCapture::Command)reader.getByte();
+			if (command == stop)
+				return true;
+
+			switch (command) {
+				case FrameCapture::EndSetup:
+				case FrameCapture::EndFrame:
+					break;
+				case FrameCapture::CreateBuffer: {
+					unsigned int name = reader.getUInt();
+					unsigned int target = reader.getUInt();
+					unsigned int size = reader.getUInt();
+					const unsigned char* data = reader.getByte() ? reader.getBytes(size) : nullptr;
+					deleteBuffer(name);
+					unsigned int buffer;
+					GLCall(glGenBuffers(1, &buffer));
+					GLCall(glBindBuffer(target, buffer));
+					GLCall(glBufferData(target, size, data, GL_STATIC_DRAW));
+					m_Buffers[name] = buffer;
+					break;
+				}
+				case FrameCapture::DeleteBuffer:
+					deleteBuffer(reader.getUInt());
+					break;
+				case FrameCapture::BufferSubData: {
+					unsigned int buffer = map(m_Buffers, reader.getUInt());
+					unsigned int offset = reader.getUInt();
+					unsigned int size = reader.getUInt();
+					const unsigned char* data = reader.getBytes(size);
+					if (buffer && data) {
+						GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+						GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+					}
+					break;
+				}
+				case FrameCapture::BindBuffer: {
+					unsigned int target = reader.getUInt();
+					GLCall(glBindBuffer(target, map(m_Buffers, reader.getUInt())));
+					break;
+				}
+				case FrameCapture::CreateVertexArray: {
+					unsigned int name = reader.getUInt();
+					deleteVertexArray(name);
+					unsigned int vertexArray;
+					GLCall(glGenVertexArrays(1, &vertexArray));
+					m_VertexArrays[name] = vertexArray;
+					break;
+				}
+				case FrameCapture::DeleteVertexArray:
+					deleteVertexArray(reader.getUInt());
+					break;
+				case FrameCapture::AddBuffer: {
+					// same attribute setup as VertexArray::addBuffer
+					unsigned int vertexArray = map(m_VertexArrays, reader.getUInt());
+					unsigned int buffer = map(m_Buffers, reader.getUInt());
+					unsigned int firstAttribute = reader.getUInt();
+					unsigned int stride = reader.getUInt();
+					unsigned int divisor = reader.getUInt();
+					unsigned int count = reader.getUInt();
+					GLCall(glBindVertexArray(vertexArray));
+					GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+					size_t offset = 0;
+					for (unsigned int i = 0; i < count && !reader.hasFailed(); i++) {
+						unsigned int type = reader.getUInt();
+						unsigned int components = reader.getUInt();
+						unsigned char normalized = reader.getByte();
+						GLCall(glEnableVertexAttribArray(firstAttribute + i));
+						GLCall(glVertexAttribPointer(firstAttribute + i, components, type, normalized, stride, (const void*)offset));
+						if (divisor) {
+							GLCall(glVertexAttribDivisor(firstAttribute + i, divisor));
+						}
+						offset += components * VertexBufferElement::getSizeOfType(type);
+					}
+					break;
+				}
+				case FrameCapture::BindVertexArray:
+					GLCall(glBindVertexArray(map(m_VertexArrays, reader.getUInt())));
+					break;
+				case FrameCapture::CreateProgram: {
+					unsigned int name = reader.getUInt();
+					ShaderProgramSources sources;
+					sources.vertexSource = reader.getString();
+					sources.fragmentSource = reader.getString();
+					m_Programs[name].reset(new Shader(sources));
+					break;
+				}
+				case FrameCapture::DeleteProgram: {
+					auto found = m_Programs.find(reader.getUInt());
+					if (found != m_Programs.end()) {
+						if (m_CurrentProgram == found->second.get())
+							m_CurrentProgram = nullptr;
+						m_Programs.erase(found);
+					}
+					break;
+				}
+				case FrameCapture::UseProgram: {
+					unsigned int name = reader.getUInt();
+					auto found = m_Programs.find(name);
+					m_CurrentProgram = found != m_Programs.end() ? found->second.get() : nullptr;
+					if (m_CurrentProgram)
+						m_CurrentProgram->bind();
+					else {
+						if (name)
+							m_UnknownNames++;
+						GLCall(glUseProgram(0));
+					}
+					break;
+				}
+				case FrameCapture::Uniform: {
+					std::string name = reader.getString();
+					unsigned int type = reader.getUInt();
+					unsigned int count = reader.getUInt();
+					const unsigned char* values = count <= 16 ? reader.getBytes(count * 4) : nullptr;
+					if (!values || !m_CurrentProgram)
+						break;
+					int location = m_CurrentProgram->getUniformLocation(name);
+					setUniform(location, type, values);
+					break;
+				}
+				case FrameCapture::ClearColor: {
+					float color[4];
+					for (int i = 0; i < 4; i++)
+						color[i] = reader.getFloat();
+					GLCall(glClearColor(color[0], color[1], color[2], color[3]));
+					break;
+				}
+				case FrameCapture::Viewport: {
+					int viewport[4];
+					for (int i = 0; i < 4; i++)
+						viewport[i] = (int)reader.getUInt();
+					GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+					break;
+				}
+				case FrameCapture::Clear:
+					GLCall(glClear(reader.getUInt()));
+					break;
+				case FrameCapture::DrawElements: {
+					unsigned int mode = reader.getUInt();
+					unsigned int count = reader.getUInt();
+					unsigned int type = reader.getUInt();
+					size_t offset = reader.getUInt();
+					GLCall(glDrawElements(mode, count, type, (const void*)offset));
+					draws++;
+					break;
+				}
+				case FrameCapture::DrawArraysInstanced: {
+					unsigned int mode = reader.getUInt();
+					unsigned int first = reader.getUInt();
+					unsigned int count = reader.getUInt();
+					unsigned int instances = reader.getUInt();
+					GLCall(glDrawArraysInstanced(mode, first, count, instances));
+					draws++;
+					break;
+				}
+				default:
+					LOG_ERROR("Unknown capture command %d", (int)command);
+					return false;
+			}
+		}
+		return !reader.hasFailed();
+	}
+
+	static void setUniform(int location, unsigned int type, const unsigned char* values) {
+		const GLfloat* floats = (const GLfloat*)values;
+		const GLint* ints = (const GLint*)values;
+		switch (type) {
+			case GL_FLOAT:			GLCall(glUniform1fv(location, 1, floats)); break;
+			case GL_FLOAT_VEC2:		GLCall(glUniform2fv(location, 1, floats)); break;
+			case GL_FLOAT_VEC3:		GLCall(glUniform3fv(location, 1, floats)); break;
+			case GL_FLOAT_VEC4:		GLCall(glUniform4fv(location, 1, floats)); break;
+			case GL_FLOAT_MAT2:		GLCall(glUniformMatrix2fv(location, 1, GL_FALSE, floats)); break;
+			case GL_FLOAT_MAT3:		GLCall(glUniformMatrix3fv(location, 1, GL_FALSE, floats)); break;
+			case GL_FLOAT_MAT4:		GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, floats)); break;
+			case GL_INT_VEC2:		GLCall(glUniform2iv(location, 1, ints)); break;
+			case GL_INT_VEC3:		GLCall(glUniform3iv(location, 1, ints)); break;
+			case GL_INT_VEC4:		GLCall(glUniform4iv(location, 1, ints)); break;
+			default:				GLCall(glUniform1iv(location, 1, ints)); break;
+		}
+	}
+};
+
+static bool readCapture(const char* filepath, unsigned int& frames, std::vector<unsigned char>& stream)
+{
+	FILE* file = fopen(filepath, "rb");
+	if (!file) {
+		LOG_ERROR("Can't open %s", filepath);
+		return false;
+	}
+
+	char magic[8];
+	unsigned int version = 0;
+	unsigned long long size = 0;
+	bool ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, "GLCAPTR", 8) == 0 &&
+		fread(&version, sizeof(version), 1, file) == 1 && version == FrameCapture::FileVersion &&
+		fread(&frames, sizeof(frames), 1, file) == 1 &&
+		fread(&size, sizeof(size), 1, file) == 1;
+	if (ok) {
+		stream.resize((size_t)size);
+		ok = fread(stream.data(), 1, stream.size(), file) == stream.size();
+	}
+	fclose(file);
+
+	if (!ok)
+		LOG_ERROR("%s isn't a complete version %u frame capture", filepath, FrameCapture::FileVersion);
+	return ok;
+}
+
+static unsigned long long hashFramebuffer(int width, int height)
+{
+	std::vector<unsigned char> pixels(width * height * 4);
+	GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+
+	unsigned long long hash = 14695981039346656037ULL;	// FNV-1a
+	for (unsigned char pixel : pixels)
+		hash = (hash ^ pixel) * 1099511628211ULL;
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argv[1][0] == '-') {
+		fprintf(stderr, "usage: %s capture.cap [--loops N] [--warmup W] [--out file.json]\n", argv[0]);
+		return 1;
+	}
+	int loops = (int)bench::getArg(argc, argv, "--loops", 100LL);
+	int warmup = (int)bench::getArg(argc, argv, "--warmup", 5LL);
+	if (loops < 1) loops = 1;
+
+	unsigned int frames = 0;
+	std::vector<unsigned char> stream;
+	if (!readCapture(argv[1], frames, stream))
+		return 1;
+
+	// the capture starts with the viewport it was taken with, size the framebuffer to match
+	CaptureReader reader(stream);
+	int width = 640, height = 480;
+	if (reader.getByte() == FrameCapture::Viewport) {
+		int x = (int)reader.getUInt(), y = (int)reader.getUInt();
+		width = x + (int)reader.getUInt();
+		height = y + (int)reader.getUInt();
+	}
+	reader.seek(0);
+
+	HeadlessContext context(width, height);
+	if (!context.isValid())
+		return -1;
+
+	std::vector<double> cpuTimes, gpuTimes;
+	unsigned long long firstHash = 0, lastHash = 0;
+	unsigned int drawsPerLoop = 0, unknownNames = 0;
+	{
+		Replayer replayer;
+		if (!replayer.execute(reader, FrameCapture::EndSetup)) {
+			LOG_ERROR("Bad capture setup");
+			return 1;
+		}
+		size_t framesStart = reader.getPosition();
+
+		std::vector<unsigned int> queries(frames);
+		GLCall(glGenQueries(frames, queries.data()));
+
+		for (int loop = 0; loop < warmup + loops; loop++) {
+			bool measured = loop >= warmup;
+			reader.seek(framesStart);
+			replayer.draws = 0;
+
+			for (unsigned int frame = 0; frame < frames; frame++) {
+				double start = bench::now();
+				GLCall(glBeginQuery(GL_TIME_ELAPSED, queries[frame]));
+				bool ok = replayer.execute(reader, FrameCapture::EndFrame);
+				GLCall(glEndQuery(GL_TIME_ELAPSED));
+				GLCall(glFlush());
+				if (!ok) {
+					LOG_ERROR("Bad capture frame %u", frame);
+					return 1;
+				}
+				if (measured)
+					cpuTimes.push_back((bench::now() - start) * 1000.0);
+			}
+
+			GLCall(glFinish());
+			if (measured) {
+				for (unsigned int frame = 0; frame < frames; frame++) {
+					GLuint64 elapsed = 0;
+					GLCall(glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &elapsed));
+					gpuTimes.push_back(elapsed / 1000000.0);
+				}
+			}
+
+			if (loop == 0)
+				firstHash = hashFramebuffer(width, height);
+			lastHash = hashFramebuffer(width, height);
+			drawsPerLoop = replayer.draws;
+		}
+
+		GLCall(glDeleteQueries(frames, queries.data()));
+		unknownNames = replayer.getUnknownNameCount();
+	}
+
+	char hash[32];
+	snprintf(hash, sizeof(hash), "%016llx", lastHash);
+
+	FILE* output = bench::openOutput(argc, argv);
+	bench::JsonWriter json(output);
+	json.beginObject();
+	json.member("benchmark", "replay");
+	json.member("capture", argv[1]);
+	json.member("renderer", (const char*)glGetString(GL_RENDERER));
+	json.member("version", (const char*)glGetString(GL_VERSION));
+	json.member("frames", frames);
+	json.member("loops", loops);
+	json.member("width", width);
+	json.member("height", height);
+	json.member("draws_per_loop", drawsPerLoop);
+	json.member("unknown_names", unknownNames);
+	json.stats("cpu_frame_ms", bench::Stats::compute(cpuTimes));
+	json.stats("gpu_frame_ms", bench::Stats::compute(gpuTimes));
+	json.member("framebuffer_hash", hash);
+	json.member("deterministic", firstHash == lastHash);
+	json.endObject();
+	bench::closeOutput(output);
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+// Decodes a GLTracer dump into text: one line per traced GL call, oldest first.
+//
+// usage: gl3FwEwTraceDecode trace.bin [--last N] [--thread T] [--summary]
+//   --last N:    only the last N records (e.g. the frames around a hitch)
+//   --thread T:  only records of tracer thread T
+//   --summary:   call count and total gap per call site instead of the call list
+
+#include "GLTracer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct CallSite {
+	int line;
+	std::string call;
+	std::string file;
+};
+
+struct SiteSummary {
+	unsigned int site;
+	unsigned long long calls;
+	unsigned long long errors;
+	unsigned long long gapNs;	// time from the previous call on the same thread to this one
+};
+
+static bool readString(FILE* file, std::string& text)
+{
+	unsigned int length = 0;
+	if (fread(&length, sizeof(length), 1, file) != 1 || length > (1u << 20))
+		return false;
+	text.resize(length);
+	return length == 0 || fread(&text[0], 1, length, file) == length;
+}
+
+static const char* getErrorName(unsigned int error)
+{
+	switch (error) {
+		case 0x0500: return "GL_INVALID_ENUM";
+		case 0x0501: return "GL_INVALID_VALUE";
+		case 0x0502: return "GL_INVALID_OPERATION";
+		case 0x0505: return "GL_OUT_OF_MEMORY";
+		case 0x0506: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+	}
+	return "unknown error";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s trace.bin [--last N] [--thread T] [--summary]\n", argv[0]);
+		return 1;
+	}
+
+	unsigned long long last = 0;
+	int thread = -1;
+	bool summary = false;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--last") == 0 && i + 1 < argc)
+			last = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--thread") == 0 && i + 1 < argc)
+			thread = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--summary") == 0)
+			summary = true;
+	}
+
+	FILE* file = fopen(argv[1], "rb");
+	if (!file) {
+		fprintf(stderr, "can't open %s\n", argv[1]);
+		return 1;
+	}
+
+	char magic[8];
+	unsigned int version = 0, siteCount = 0;
+	unsigned long long count = 0, total = 0;
+	if (fread(magic, 1, 8, file) != 8 || memcmp(magic, "GLTRACE", 8) != 0 ||
+		fread(&version, sizeof(version), 1, file) != 1 || version != GLTracer::FileVersion ||
+		fread(&siteCount, sizeof(siteCount), 1, file) != 1 ||
+		fread(&count, sizeof(count), 1, file) != 1 ||
+		fread(&total, sizeof(total), 1, file) != 1) {
+		fprintf(stderr, "%s isn't a version %u GL trace\n", argv[1], GLTracer::FileVersion);
+		fclose(file);
+		return 1;
+	}
+
+	std::vector<CallSite> sites(siteCount);
+	for (CallSite& site : sites) {
+		if (fread(&site.line, sizeof(site.line), 1, file) != 1 || !readString(file, site.call) || !readString(file, site.file)) {
+			fprintf(stderr, "truncated call site table\n");
+			fclose(file);
+			return 1;
+		}
+	}
+
+	std::vector<GLTraceRecord> records((size_t)count);
+	size_t read = count ? fread(records.data(), sizeof(GLTraceRecord), (size_t)count, file) : 0;
+	fclose(file);
+	if (read != count) {
+		fprintf(stderr, "truncated trace, %zu of %llu records\n", read, count);
+		records.resize(read);
+	}
+
+	if (thread >= 0) {
+		records.erase(std::remove_if(records.begin(), records.end(), [thread](const GLTraceRecord& record) {
+			return record.thread != thread;
+		}), records.end());
+	}
+	if (last > 0 && records.size() > last)
+		records.erase(records.begin(), records.end() - (size_t)last);
+
+	printf("# %llu calls traced, %llu in the ring, %zu shown, %u call sites\n", total, count, records.size(), siteCount);
+	if (records.empty())
+		return 0;
+
+	unsigned long long start = records.front().timestamp;
+	std::vector<unsigned long long> previous(65536, 0);	// last timestamp per thread
+	std::vector<SiteSummary> summaries(siteCount + 1);
+	for (unsigned int i = 0; i <= siteCount; i++)
+		summaries[i] = { i, 0, 0, 0 };
+
+	for (const GLTraceRecord& record : records) {
+		const CallSite* site = record.site >= 1 && record.site <= siteCount ? &sites[record.site - 1] : nullptr;
+		unsigned long long gap = previous[record.thread] ? record.timestamp - previous[record.thread] : 0;
+		previous[record.thread] = record.timestamp;
+
+		if (summary) {
+			SiteSummary& entry = summaries[site ? record.site : 0];
+			if (record.error)
+				entry.errors++;
+			else {
+				entry.calls++;
+				entry.gapNs += gap;
+			}
+			continue;
+		}
+
+		if (record.error) {
+			printf("%12.6f ms  T%-2u  !! %s (0x%04x) after %s\n", (record.timestamp - start) / 1e6, record.thread,
+				getErrorName(record.error), record.error, site ? site->call.c_str() : "an unknown call");
+			continue;
+		}
+		printf("%12.6f ms  T%-2u  +%9.3f us  %s", (record.timestamp - start) / 1e6, record.thread, gap / 1e3,
+			site ? site->call.c_str() : "?");
+		if (site)
+			printf("  (%s:%d)", site->file.c_str(), site->line);
+		printf("\n");
+	}
+
+	if (summary) {
+		std::sort(summaries.begin(), summaries.end(), [](const SiteSummary& a, const SiteSummary& b) {
+			return a.calls > b.calls;
+		});
+		printf("%10s %8s %12s  %s\n", "calls", "errors", "gap ms", "call site");
+		for (const SiteSummary& entry : summaries) {
+			if (entry.calls == 0 && entry.errors == 0)
+				continue;
+			const CallSite* site = entry.site ? &sites[entry.site - 1] : nullptr;
+			printf("%10llu %8llu %12.3f  %s", entry.calls, entry.errors, entry.gapNs / 1e6, site ? site->call.c_str() : "?");
+			if (site)
+				printf("  (%s:%d)", site->file.c_str(), site->line);
+			printf("\n");
+		}
+	}
+	return 0;
+}